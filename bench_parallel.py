@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+
+# Scaling benchmark of the parallel A* (HDA*): the same puzzle is solved by
+# sequential A* and by HDA* with 1, 2, 4 ... N threads, speedup is measured
+# against sequential A*. Paths' length must stay the same for every run.
+# $ ./bench_parallel.py -f maps/hard.txt -e 3
+
+import argparse
+import os
+import random
+import re
+import subprocess
+import tempfile
+
+def make_goal(s):
+	puzzle = [i + 1 for i in range(s * s)]
+	puzzle[-1] = 0
+	return puzzle
+
+def make_puzzle(s, iterations):
+	p = make_goal(s)
+	prev = -1
+	for i in range(iterations):
+		idx = p.index(0)
+		poss = []
+		if idx % s > 0:
+			poss.append(idx - 1)
+		if idx % s < s - 1:
+			poss.append(idx + 1)
+		if idx // s > 0:
+			poss.append(idx - s)
+		if idx // s < s - 1:
+			poss.append(idx + s)
+		poss = [i for i in poss if i != prev] or poss
+		swi = random.choice(poss)
+		p[idx] = p[swi]
+		p[swi] = 0
+		prev = idx
+	return p
+
+def write_puzzle(s, puzzle):
+	f = tempfile.NamedTemporaryFile("w", suffix=".txt", delete=False)
+	f.write("# random puzzle\n%d\n" % s)
+	for y in range(s):
+		f.write(" ".join(str(x) for x in puzzle[y * s:(y + 1) * s]) + "\n")
+	f.close()
+	return f.name
+
+def solve(args, algorithm, threads):
+	command = [args.binary, "-f", args.file, "-e", str(args.heuristic), "-s", "1",
+				"-o", "0", "-a", str(algorithm), "-t", str(threads), "-v", "4"]
+	output = subprocess.run(command, stdout=subprocess.PIPE, universal_newlines=True, check=True).stdout
+	result = {}
+	for key, pattern in (("time", r"Elapsed time: ([\d.e-]+)"),
+						("closed", r"Closed nodes: (\d+)"),
+						("length", r"Paths' length: (\d+)")):
+		match = re.search(pattern, output)
+		if match is None:
+			raise RuntimeError("unexpected output of npuzzle:\n" + output)
+		result[key] = float(match.group(1))
+	return result
+
+if __name__ == "__main__":
+	parser = argparse.ArgumentParser()
+
+	parser.add_argument("-b", "--binary", default="./npuzzle", help="Path to npuzzle")
+	parser.add_argument("-f", "--file", help="File with map, random one if not set")
+	parser.add_argument("-n", "--size", type=int, default=4, help="Size of the random puzzle's side")
+	parser.add_argument("-i", "--iterations", type=int, default=200, help="Random moves from the goal")
+	parser.add_argument("-e", "--heuristic", type=int, default=3, help="Heuristic")
+	parser.add_argument("-t", "--threads", type=int, default=os.cpu_count(), help="Max amount of threads")
+	parser.add_argument("-r", "--repeat", type=int, default=3, help="Runs of every setup, the best one counts")
+	parser.add_argument("--seed", type=int, default=42)
+
+	args = parser.parse_args()
+
+	temporary = args.file is None
+	if temporary:
+		random.seed(args.seed)
+		args.file = write_puzzle(args.size, make_puzzle(args.size, args.iterations))
+
+	try:
+		base = min((solve(args, 0, 1) for i in range(args.repeat)), key=lambda r: r["time"])
+		print("threads  seconds  closed nodes  length  speedup")
+		print("     A*  %7.2f  %12d  %6d  %7.2f" % (base["time"], base["closed"], base["length"], 1))
+		threads = 1
+		while True:
+			result = min((solve(args, 2, threads) for i in range(args.repeat)), key=lambda r: r["time"])
+			print("%7d  %7.2f  %12d  %6d  %7.2f" % (threads, result["time"], result["closed"],
+													result["length"], base["time"] / result["time"]))
+			if result["length"] != base["length"]:
+				print("Error: length differs from sequential A*")
+			if threads >= args.threads:
+				break
+			threads = min(threads * 2, args.threads)
+	finally:
+		if temporary:
+			os.remove(args.file)
@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+
+# Regression check of --batch: maps of map/solvable, map/unsolvable and broken maps
+# are solved by one run, every map must get its own line and the run must not crash.
+# $ ./check_batch.py -b ./npuzzle
+
+import argparse
+import glob
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+# broken maps, each one must be reported as an invalid map
+BROKEN_MAPS = {
+	"size_0.txt": "0\n1 2\n",
+	"size_2.txt": "2\n1 0\n2 3\n",
+	"short.txt": "3\n1 2 3\n",
+	"letters.txt": "3\n1 2 x\n3 4 5\n6 7 0\n",
+}
+
+def expected_status(name):
+	if name.startswith("solvable_"):
+		return "solved"
+	if name.startswith("unsolvable_"):
+		return "Map is unsolvable or not squared"
+	return "Invalid map"
+
+if __name__ == "__main__":
+	parser = argparse.ArgumentParser()
+
+	parser.add_argument("-b", "--binary", default="./npuzzle", help="Path to npuzzle")
+	parser.add_argument("-w", "--workers", type=int, default=2, help="Workers of the batch")
+
+	args = parser.parse_args()
+
+	directory = tempfile.mkdtemp()
+	try:
+		for kind in ("solvable", "unsolvable"):
+			for path in glob.glob(os.path.join("map", kind, "*.txt")):
+				shutil.copy(path, os.path.join(directory, kind + "_" + os.path.basename(path)))
+		for name, text in BROKEN_MAPS.items():
+			with open(os.path.join(directory, name), "w") as f:
+				f.write(text)
+
+		# solutions by time, so every solvable map is solved fast
+		command = [args.binary, "--batch", directory, "--format", "jsonl", "-e", "3", "-s", "0",
+					"-o", "1", "-w", str(args.workers)]
+		process = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+									universal_newlines=True)
+		if process.returncode != 0:
+			sys.exit("npuzzle exited with %d:\n%s" % (process.returncode, process.stderr))
+
+		results = {os.path.basename(line["file"]): line["status"]
+					for line in map(json.loads, process.stdout.splitlines())}
+		failed = False
+		for name in sorted(os.listdir(directory)):
+			status = results.get(name)
+			if status != expected_status(name):
+				print("%s: expected '%s', got '%s'" % (name, expected_status(name), status))
+				failed = True
+		if failed:
+			sys.exit(1)
+		print("%d maps are checked" % len(results))
+	finally:
+		shutil.rmtree(directory)
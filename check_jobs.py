@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+
+# Check of the queue of jobs of the solving server: submit, status, cancel and fetch
+# of a job which is solved, then cancel of a long one. Exit status is 1 on a wrong answer.
+# Start the server first, e.g.  $ ./npuzzle -w 2
+
+import argparse
+import json
+import sys
+import time
+import urllib.request
+
+TASK, SOLUTION, ERROR, PROGRESS, SUBMIT, STATUS, FETCH, CANCEL, JOB = range(9)
+
+EASY_MAP = [0, 3, 5, 6, 7, 1, 4, 2, 8]
+# the solve by misplaced tiles and paths' length takes far more than the check
+HARD_MAP = [0, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1]
+
+def send(url, message_type, data):
+	body = json.dumps({"messageType": message_type, "data": data}).encode()
+	request = urllib.request.Request(url, data=body, headers={"Content-Type": "application/json"})
+	with urllib.request.urlopen(request) as response:
+		return json.loads(response.read().decode())
+
+def expect(answer, message_type, status=None):
+	# values of answers are strings
+	if int(answer["messageType"]) != message_type or (status and answer["data"]["status"] != status):
+		sys.exit("unexpected answer: %s" % json.dumps(answer))
+
+def wait(url, job, statuses, timeout):
+	deadline = time.time() + timeout
+	while True:
+		answer = send(url, STATUS, {"id": job})
+		expect(answer, JOB)
+		if answer["data"]["status"] in statuses:
+			return answer
+		if time.time() > deadline:
+			sys.exit("job %s is still %s" % (job, answer["data"]["status"]))
+		time.sleep(0.1)
+
+if __name__ == "__main__":
+	parser = argparse.ArgumentParser()
+
+	parser.add_argument("-u", "--url", default="http://localhost:8080/message", help="Url of messages")
+	parser.add_argument("-t", "--timeout", type=float, default=30, help="Seconds to wait for a job")
+
+	args = parser.parse_args()
+
+	# done job: status and cancel answer with Job, fetch gives the solution once
+	answer = send(args.url, SUBMIT, {"map": EASY_MAP, "heuristicFunction": 3, "solutionType": 1,
+									"optimisation": 0})
+	expect(answer, JOB)
+	job = answer["data"]["id"]
+	wait(args.url, job, ("done",), args.timeout)
+	expect(send(args.url, STATUS, {"id": job}), JOB, "done")
+	expect(send(args.url, CANCEL, {"id": job}), JOB, "done")
+	answer = send(args.url, FETCH, {"id": job})
+	expect(answer, SOLUTION)
+	if not answer["data"]["movements"]:
+		sys.exit("solution without movements: %s" % json.dumps(answer))
+	expect(send(args.url, FETCH, {"id": job}), ERROR)
+
+	# cancelled job: its answer is the Job, it's forgotten after the fetch
+	answer = send(args.url, SUBMIT, {"map": HARD_MAP, "heuristicFunction": 0, "solutionType": 1,
+									"optimisation": 0})
+	expect(answer, JOB)
+	job = answer["data"]["id"]
+	expect(send(args.url, CANCEL, {"id": job}), JOB)
+	wait(args.url, job, ("cancelled",), args.timeout)
+	expect(send(args.url, FETCH, {"id": job}), JOB, "cancelled")
+	expect(send(args.url, FETCH, {"id": job}), ERROR)
+
+	# a message without its id is an error
+	expect(send(args.url, STATUS, {}), ERROR)
+	print("Jobs are ok")
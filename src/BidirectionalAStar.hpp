@@ -0,0 +1,225 @@
+#ifndef BIDIRECTIONAL_A_STAR_HPP
+#define BIDIRECTIONAL_A_STAR_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include "NPuzzleSolver.hpp"
+#include "SolverContext.hpp"
+
+/*
+ * Bidirectional A* in the meet in the middle order (MM): the forward side searches
+ * from the map to the finish state, the backward one from the finish state to the map
+ * with the heuristic to the map. The side with the smaller key of its open list
+ * is expanded. Every board which gets a shorter path is looked up in the table
+ * of the other side, the shortest meeting is the path.
+ *
+ * With optimisation by paths' length the search stops when no unseen path can be
+ * shorter than the best meeting: it's bounded by the smallest key of both sides,
+ * by the smallest cost of either side and by the smallest lengths of both sides plus one.
+ * Keys aren't costs, so an expanded board is opened again when it comes with a shorter path.
+ * With optimisation by time the first meeting is the answer.
+ */
+template <typename Board>
+class BidirectionalAStar
+{
+	enum sides { FORWARD, BACKWARD, SIDES };
+
+	struct Side {
+		const SolverContext<Board>	&ctx;
+		NodeArena<State<Board>>		arena;
+		MeetingOpenList<Board>		open;
+		NodeTable<Board>			table;
+
+		explicit Side(const SolverContext<Board> &ctx) : ctx(ctx), open(&arena, ctx.byPrice), table(&arena) {};
+	};
+
+	const SolverContext<Board>	&ctx;
+	SolverContext<Board>		backward;	// heuristic to the map
+	std::unique_ptr<Side>		sides[SIDES];
+	Profiler					profiler;
+	size_t						expanded;
+	size_t						generated;
+	size_t						duplicates;
+	size_t						maxOpen;
+	int							best;				// length of the shortest meeting
+	uint32_t					meeting[SIDES];		// nodes of the shortest meeting
+
+	//disable copy constructor;
+	BidirectionalAStar(const BidirectionalAStar &rhs);
+	BidirectionalAStar	&operator=(const BidirectionalAStar &rhs);
+
+	size_t	usedMemory() const {
+		size_t	bytes = 0;
+
+		for (auto const &side : sides)
+			bytes += side->arena.usedMemory() + side->open.usedMemory() + side->table.usedMemory();
+		return (bytes);
+	}
+
+	void	saveStats(NP_retVal &result, std::chrono::steady_clock::time_point searchStart) {
+		profiler.stop(EXPANSION_PHASE, searchStart, expanded);
+		profiler.save(result.profile);
+		result.maxOpen = maxOpen;
+		result.closedNodes = expanded;
+		result.generatedNodes = generated;
+		result.duplicates = duplicates;
+		result.usedMemory = usedMemory();
+	}
+
+	// the board of the new node of side 's' may be known by the other side
+	void	meet(int s, uint32_t node) {
+		const State<Board>	&state = sides[s]->arena[node];
+		const Side			&other = *sides[1 - s];
+		auto				timer = profiler.start();
+		const uint32_t		known = other.table.lookup(state.getBoard(), state.getHash());
+
+		profiler.stop(CLOSED_SET_PHASE, timer);
+		if (known != NP_NO_NODE && state.getLength() + other.arena[known].getLength() < best) {
+			best = state.getLength() + other.arena[known].getLength();
+			meeting[s] = node;
+			meeting[1 - s] = known;
+		}
+	}
+
+	bool	isDone() const {
+		const MeetingOpenList<Board>	&forward = sides[FORWARD]->open;
+		const MeetingOpenList<Board>	&back = sides[BACKWARD]->open;
+
+		if (best == std::numeric_limits<int>::max())
+			return (false);
+		if (ctx.byPrice)
+			return (true);
+		return (best <= std::max({std::min(forward.getMinKey(), back.getMinKey()),
+									forward.getMinCost(), back.getMinCost(),
+									forward.getMinLength() + back.getMinLength() + 1}));
+	}
+
+	// false if the node was left behind by a shorter path to its board
+	bool	expand(int s) {
+		Side		&side = *sides[s];
+		auto		timer = profiler.start();
+		uint32_t	curr = side.open.top();
+		int			moves[LAST];
+		int			movesCount;
+		bool		inserted;
+
+		side.open.pop();
+		profiler.stop(OPEN_LIST_PHASE, timer);
+
+		// shorter path to the board was found after the node was pushed
+		timer = profiler.start();
+		typename NodeTable<Board>::Slot	&slot = side.table.find(curr);
+		profiler.stop(CLOSED_SET_PHASE, timer);
+		if (slot.getNode() != curr)
+			return (false);
+		slot.close();
+		expanded++;
+
+		const State<Board>	&state = side.arena[curr];
+
+		movesCount = state.getMoves(side.ctx, moves);
+		generated += movesCount;
+		for (int i = 0; i < movesCount; i++) {
+			timer = profiler.start();
+			const uint32_t	child = side.arena.create(side.ctx, state, moves[i], curr);
+			profiler.stop(HEURISTIC_PHASE, timer);
+
+			timer = profiler.start();
+			typename NodeTable<Board>::Slot	&known = side.table.insert(child, inserted);
+			profiler.stop(CLOSED_SET_PHASE, timer);
+			if (!inserted) {
+				// greedy search doesn't reopen expanded boards, like A* doesn't
+				if ((ctx.byPrice && known.isClosed()) ||
+					side.arena[known.getNode()].getLength() <= side.arena[child].getLength()) {
+					side.arena.dropLast();
+					duplicates++;
+					continue;
+				}
+				known.replace(child);
+			}
+			meet(s, child);
+			timer = profiler.start();
+			side.open.push(child);
+			profiler.stop(OPEN_LIST_PHASE, timer);
+		}
+		return (true);
+	}
+
+public:
+	BidirectionalAStar(const SolverContext<Board> &ctx, const int *map, const int *finishMap)
+		: ctx(ctx), backward(ctx.mapLength, ctx.byPrice), profiler(ctx.profiling), expanded(0),
+		generated(0), duplicates(0), maxOpen(0), best(std::numeric_limits<int>::max()),
+		meeting{NP_NO_NODE, NP_NO_NODE}
+	{
+		backward.heuristicFunc = ctx.heuristicFunc;
+		backward.heuristicDelta = ctx.heuristicDelta;
+		backward.profiling = ctx.profiling;
+		// solveBoard rejects pattern databases which can't be turned to the map
+		backward.heuristic.initReversed(ctx.heuristic, finishMap, map);
+		sides[FORWARD].reset(new Side(ctx));
+		sides[BACKWARD].reset(new Side(backward));
+	}
+
+	void	solve(const int *map, const int *finishMap, NP_retVal &result) {
+		const auto	searchStart = profiler.start();
+		bool		inserted;
+		int			limit;
+
+		for (int s = FORWARD; s < SIDES; s++) {
+			Side	&side = *sides[s];
+
+			side.open.push(side.arena.create(side.ctx, s == FORWARD ? map : finishMap));
+			side.table.insert(side.open.top(), inserted);
+		}
+		meet(FORWARD, sides[FORWARD]->open.top());
+
+		while (!sides[FORWARD]->open.empty() && !sides[BACKWARD]->open.empty() && !isDone()) {
+			const MeetingOpenList<Board>	&forward = sides[FORWARD]->open;
+			const MeetingOpenList<Board>	&back = sides[BACKWARD]->open;
+			// the smaller key, then the smaller side
+			const int						s = (forward.getMinKey() < back.getMinKey() ||
+												(forward.getMinKey() == back.getMinKey() &&
+												forward.size() <= back.size())) ? FORWARD : BACKWARD;
+
+			if (!expand(s))
+				continue;
+			maxOpen = std::max(maxOpen, forward.size() + back.size());
+
+			// open lists are counted by their sizes, exact sum of their vectors is too slow here
+			if (expanded % BudgetWatch::period == 0 &&
+				(limit = ctx.budget.check(expanded, sides[FORWARD]->arena.usedMemory() +
+											sides[BACKWARD]->arena.usedMemory() +
+											sides[FORWARD]->table.usedMemory() +
+											sides[BACKWARD]->table.usedMemory() +
+											(forward.size() + back.size()) * sizeof(uint32_t),
+											forward.size() + back.size(),
+											std::min(forward.getMinKey(), back.getMinKey()))) != NO_LIMIT) {
+				saveStats(result, searchStart);
+				throw NPuzzleSolver::NP_BudgetExceeded(limit);
+			}
+		}
+		saveStats(result, searchStart);
+		if (best == std::numeric_limits<int>::max())
+			throw NPuzzleSolver::NP_InvalidMap();
+
+		Profiler	pathProfiler(ctx.profiling);
+		const auto	timer = pathProfiler.start();
+		const Side	&forwardSide = *sides[FORWARD];
+		const Side	&backwardSide = *sides[BACKWARD];
+
+		// moves of the backward half go from the meeting to the finish, so they are opposite and reversed
+		for (const State<Board> *ptr = &forwardSide.arena[meeting[FORWARD]]; ptr->getMove() != ROOT;
+			ptr = &forwardSide.arena[ptr->getPrev()])
+			result.path.push_front(ptr->getMove());
+		result.path.push_front(ROOT);
+		for (const State<Board> *ptr = &backwardSide.arena[meeting[BACKWARD]]; ptr->getMove() != ROOT;
+			ptr = &backwardSide.arena[ptr->getPrev()])
+			result.path.push_back(State<Board>::getOppositeMove(ptr->getMove()));
+		pathProfiler.stop(PATH_PHASE, timer);
+		pathProfiler.save(result.profile);
+	}
+};
+
+#endif // BIDIRECTIONAL_A_STAR_HPP
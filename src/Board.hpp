@@ -0,0 +1,73 @@
+#ifndef BOARD_HPP
+#define BOARD_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * Puzzle board packed into fixed amount of 64-bit words,
+ * every cell takes 'Bits' bits and cells never cross a word boundary.
+ */
+template <int Bits, int Words>
+class PackedBoard
+{
+	static const int		cellsPerWord = 64 / Bits;
+	static const uint64_t	cellMask = (1ULL << Bits) - 1;
+
+	uint64_t	words[Words];
+
+public:
+	// max amount of cells which can be stored, limited by cell width too
+	static const int	maxLength = (cellsPerWord * Words < (1 << Bits)) ?
+									cellsPerWord * Words : (1 << Bits);
+
+	PackedBoard() { clear(); }
+
+	void	clear() {
+		for (int i = 0; i < Words; i++)
+			words[i] = 0;
+	}
+
+	int		get(int i) const {
+		return ((int)((words[i / cellsPerWord] >> ((i % cellsPerWord) * Bits)) & cellMask));
+	}
+
+	void	set(int i, int value) {
+		const int	shift = (i % cellsPerWord) * Bits;
+		uint64_t	&word = words[i / cellsPerWord];
+
+		word = (word & ~(cellMask << shift)) | ((uint64_t)value << shift);
+	}
+
+	void	swap(int a, int b) {
+		const int	tmp = get(a);
+
+		set(a, get(b));
+		set(b, tmp);
+	}
+
+	void	pack(const int *map, int length) {
+		clear();
+		for (int i = 0; i < length; i++)
+			set(i, map[i]);
+	}
+
+	void	unpack(int *map, int length) const {
+		for (int i = 0; i < length; i++)
+			map[i] = get(i);
+	}
+
+	bool	operator==(const PackedBoard &rhs) const {
+		for (int i = 0; i < Words; i++)
+			if (words[i] != rhs.words[i])
+				return (false);
+		return (true);
+	}
+
+	bool	operator!=(const PackedBoard &rhs) const { return (!(*this == rhs)); }
+};
+
+typedef PackedBoard<4, 1>	NP_Board16;	// boards up to 4x4, nibble per cell
+typedef PackedBoard<6, 7>	NP_Board64;	// boards from 5x5 up to 8x8
+
+#endif // BOARD_HPP
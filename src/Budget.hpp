@@ -0,0 +1,107 @@
+#ifndef BUDGET_HPP
+#define BUDGET_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+enum budgetLimits { NO_LIMIT = -1, TIME_LIMIT, NODES_LIMIT, MEMORY_LIMIT, CANCELLED };
+
+// state of a running solve, see NP_budget::progress
+class NP_progress {
+public:
+	size_t	expanded;
+	size_t	open;			// nodes of the open list, HDA* estimates it by the list of one thread
+	int		bound;			// cost of the expanded node, the threshold of IDA*
+	size_t	memory;			// bytes
+	double	elapsedTime;	// seconds since the solve started
+	double	nodesPerSecond;
+};
+
+/*
+ * Limits of one solve, 0 means unlimited.
+ * 'cancel' is shared with another thread which can stop the solve at any moment,
+ * e.g. when client of the request is gone.
+ * 'progress' is called every 'progressPeriod' seconds by the solving thread,
+ * by one of the threads for HDA*, it must not throw.
+ */
+class NP_budget {
+public:
+	typedef std::function<void(const NP_progress &progress)>	ProgressFunc;
+
+	double								maxTime;		// seconds of wall time
+	size_t								maxExpanded;
+	size_t								maxMemory;		// bytes
+	std::shared_ptr<std::atomic<bool>>	cancel;
+	ProgressFunc						progress;		// empty if nobody watches the solve
+	double								progressPeriod;	// seconds
+
+	NP_budget() : maxTime(0), maxExpanded(0), maxMemory(0), progressPeriod(1) {};
+};
+
+/*
+ * Budget of a running solve. Searches check it once per 'period' expansions,
+ * so the clock isn't read for every node. Without 'progress' the report costs
+ * a test of the pointer to its schedule.
+ */
+class BudgetWatch {
+	typedef std::chrono::steady_clock	clock;
+
+	NP_budget							budget;
+	clock::time_point					start;
+	clock::time_point					deadline;
+	std::shared_ptr<std::atomic<int64_t>>	nextReport;	// ticks of the clock, shared by copies of the watch
+
+	static clock::duration	seconds(double time) {
+		return (std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(time)));
+	}
+
+	void	report(size_t expanded, size_t memory, size_t open, int bound, clock::time_point now) const {
+		int64_t			next = nextReport->load(std::memory_order_relaxed);
+		const int64_t	ticks = now.time_since_epoch().count();
+		NP_progress		progress;
+
+		// threads of HDA* check at once, only one of them reports
+		if (ticks < next || !nextReport->compare_exchange_strong(next, ticks + seconds(budget.progressPeriod).count()))
+			return ;
+		progress.expanded = expanded;
+		progress.open = open;
+		progress.bound = bound;
+		progress.memory = memory;
+		progress.elapsedTime = std::chrono::duration<double>(now - start).count();
+		progress.nodesPerSecond = progress.elapsedTime > 0 ? expanded / progress.elapsedTime : 0;
+		budget.progress(progress);
+	}
+
+public:
+	static const size_t	period = 1024;
+
+	BudgetWatch() {};
+	explicit BudgetWatch(const NP_budget &budget)
+		: budget(budget), start(clock::now()),
+		deadline(start + seconds(budget.maxTime)),
+		nextReport(budget.progress ?
+					new std::atomic<int64_t>((start + seconds(budget.progressPeriod)).time_since_epoch().count()) :
+					nullptr) {};
+
+	// limit which is hit, NO_LIMIT if the search can go on
+	// 'open' and 'bound' are only reported, searches without them give 0
+	int		check(size_t expanded, size_t memory, size_t open = 0, int bound = 0) const {
+		if (nextReport)
+			report(expanded, memory, open, bound, clock::now());
+		if (budget.cancel && budget.cancel->load(std::memory_order_relaxed))
+			return (CANCELLED);
+		if (budget.maxExpanded != 0 && expanded >= budget.maxExpanded)
+			return (NODES_LIMIT);
+		if (budget.maxMemory != 0 && memory >= budget.maxMemory)
+			return (MEMORY_LIMIT);
+		if (budget.maxTime > 0 && clock::now() >= deadline)
+			return (TIME_LIMIT);
+		return (NO_LIMIT);
+	}
+};
+
+#endif // BUDGET_HPP
@@ -1,10 +1,18 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <fstream>
+#include <mutex>
+#include <sstream>
+#include <boost/filesystem.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/thread.hpp>
 
 #include "main.hpp"
 #include "CLI.hpp"
 #include "NPuzzleSolver.hpp"
+#include "PatternDatabase.hpp"
 
 bool	CLI::isFlagSet(const std::string &flag) const {
 	if (this->vm.count(flag))
@@ -26,6 +34,20 @@ bool	CLI::getFlag(const std::string &flag, int &result) const {
 	return (false);
 }
 
+bool	CLI::getFlag(const std::string &flag, double &result) const {
+	if (this->vm.count(flag)) {
+		try {
+			result = this->vm[flag].as<double>();
+		}
+		catch (std::exception &e) {
+			std::cerr << "Error: " << e.what() << std::endl;
+			return (false);
+		}
+		return (true);
+	}
+	return (false);
+}
+
 bool	CLI::getFlag(const std::string &flag, std::string &result) const {
 	if (this->vm.count(flag)) {
 		try {
@@ -40,6 +62,18 @@ bool	CLI::getFlag(const std::string &flag, std::string &result) const {
 	return (false);
 }
 
+NP_budget	CLI::getBudget() const {
+	NP_budget	budget;
+
+	if (this->vm.count("max-time"))
+		budget.maxTime = this->vm["max-time"].as<double>();
+	if (this->vm.count("max-nodes"))
+		budget.maxExpanded = this->vm["max-nodes"].as<size_t>();
+	if (this->vm.count("max-memory"))
+		budget.maxMemory = this->vm["max-memory"].as<size_t>() << 20;
+	return (budget);
+}
+
 bool	CLI::processArguments(int argc, char **argv) {
 	namespace po = boost::program_options;
 	try {
@@ -76,14 +110,52 @@ CLI::CLI(int argc, char **argv) : desc("Options") {
 								"\t1 -- manhattan distance\n"
 								"\t2 -- misplaced tiles + linear conflicts\n"
 								"\t3 -- manhattan distance + linear conflicts\n"
-								"\t4 -- nMaxSwap")
+								"\t4 -- nMaxSwap\n"
+								"\t5 -- additive pattern database,\n"
+								"\t     tables are built by npuzzle_pdb_gen")
 			("solution,s", po::value<int>(), "Solution type\n"
 								"\t0 -- snail solution\n"
 								"\t1 -- linear solution\n")
-			("optimisation,o", po::value<int>(&optimisationByTime), "Optimisation\n"
+			("optimisation,o", po::value<int>(), "Optimisation\n"
 								"\t0 -- optimisation by paths' length\n"
-								"\t1 -- optimisation by time (default)")
-			("file,f", po::value<std::string>(), "File with map to solve");
+								"\t1 -- optimisation by time (default)\n"
+								"\t2 -- weighted A*, paths are at most --weight\n"
+								"\t     times longer than the shortest ones\n"
+								"\t3 -- anytime A*, weighted A* improves its path\n"
+								"\t     till it's the shortest or the budget is over")
+			("weight", po::value<double>(), "Weight of the heuristic of -o 2 and the first one\n"
+								"\tof -o 3, from 1 to 10, 2 by default")
+			("algorithm,a", po::value<int>(), "Search algorithm\n"
+								"\t0 -- A* (default)\n"
+								"\t1 -- IDA*, memory is linear in paths' length,\n"
+								"\t     always optimises by paths' length\n"
+								"\t2 -- parallel A* (HDA*), uses --threads\n"
+								"\t3 -- bidirectional A* (MM), meets from the map\n"
+								"\t     and from the finish state, with -e 5 the\n"
+								"\t     empty piece of the map must be on its\n"
+								"\t     finish place")
+			("threads,t", po::value<int>(), "Threads of parallel A*, amount of cores by default")
+			("workers,w", po::value<int>(), "Threads of the server or of --batch, amount of cores\n"
+								"\tby default, every thread solves its own puzzle")
+			("max-time", po::value<double>(), "Time limit of a solve in seconds")
+			("max-nodes", po::value<size_t>(), "Limit of expanded nodes of a solve")
+			("max-memory", po::value<size_t>(), "Memory limit of a solve in Mb,\n"
+								"\tlimits apply to every request of the server too")
+			("cache", po::value<int>()->default_value(64), "Memory of the server's cache of answers in Mb,\n"
+								"\t0 disables it")
+			("cache-file", po::value<std::string>(), "Snapshot of the server's cache, it's loaded\n"
+								"\tat start and saved every minute")
+			("pdb,p", po::value<std::string>(&PatternDatabase::directory),
+								"Directory with pattern databases, 'pdb' by default")
+			("file,f", po::value<std::string>(), "File with map to solve")
+			("profile", "Print time of every phase of the solve,\n"
+								"\tthe search is slower while it's timed")
+			("batch,b", po::value<std::string>(), "Directory with maps or file with list of maps,\n"
+								"\tone line of results per map is printed to stdout,\n"
+								"\ttotals are printed to stderr")
+			("format", po::value<std::string>()->default_value("csv"), "Results of --batch\n"
+								"\tcsv   -- comma separated values with header\n"
+								"\tjsonl -- JSON object per line");
 
 	if (!processArguments(argc, argv))
 		throw CLI_invalidArguments();
@@ -91,45 +163,50 @@ CLI::CLI(int argc, char **argv) : desc("Options") {
 
 CLI::~CLI() {}
 
-static NP_retVal	solvePuzzle(const int *map, int mapSize, int heuristic, int solutionType) {
+static NP_retVal	solvePuzzle(const int *map, int mapSize, int heuristic, int solutionType, int algorithm,
+								int optimisation, double weight, int threads, const NP_budget &budget,
+								bool profile) {
 	NPuzzleSolver	solver;
 	NP_retVal		result;
-	clock_t			start;
-	float			elapsedTime;
 
-	result.maxOpen = 0;
-	result.closedNodes = 0;
-	result.usedMemory = 0;
+	solver.setProfiling(profile);
+	solver.setWeight(weight);
 	try {
-		start = clock();
-		solver.solve(heuristic, solutionType, map, mapSize * mapSize, result);
-		start = clock() - start;
-		elapsedTime = (float)start / CLOCKS_PER_SEC;
+		solver.solve(heuristic, solutionType, map, mapSize * mapSize, result,
+						BUCKET_QUEUE, algorithm, optimisation, threads, budget);
 	}
 	catch (std::exception &e) {
 		std::cerr << "Error: " << e.what() << std::endl;
 	}
 	if (verboseLevel & NP_VBL_RESULT) {
 		std::cout << "#### Results ####" << std::endl;
-		std::cout << "Elapsed time: " << elapsedTime << " sec." << std::endl
+		std::cout << "Elapsed time: " << result.elapsedTime << " sec." << std::endl
 					<< "Max open nodes: " << result.maxOpen << std::endl
 					<< "Closed nodes: " << result.closedNodes << std::endl
+					<< "Generated nodes: " << result.generatedNodes << std::endl
+					<< "Duplicates: " << result.duplicates << std::endl
+					<< "Nodes per second: " << (size_t)result.nodesPerSecond << std::endl
 					<< "Paths' length: " << result.path.size() << std::endl
 					<< "Used memory: " << result.usedMemory << " bytes" << std::endl;
+		for (auto const &improvement : result.improvements)
+			std::cout << "Improvement: " << improvement.moves << " moves, bound " << improvement.bound
+						<< ", " << improvement.time << " sec., " << improvement.expanded << " closed nodes"
+						<< std::endl;
+	}
+	if (result.profile.enabled) {
+		std::cout << "#### Profile ####" << std::endl;
+		for (int phase = 0; phase < PHASES; phase++)
+			std::cout << NP_profile::name(phase) << ": " << result.profile.time[phase] << " sec., "
+						<< result.profile.calls[phase] << " calls" << std::endl;
 	}
 	return (result);
 }
 
-void	CLI::startLogic() const {
+void	CLI::readMap(const std::string &fileName, int &mapSize, std::vector<int> &map) {
 	std::vector<int>	resultVector;
-	std::vector<int>	map;
-	std::string			fileName;
 	std::ifstream		file;
 	std::string			line;
-	NP_retVal			result;
-	int					mapSize, heuristic = 0, solutionType = 0;
 
-	this->getFlag("file", fileName);
 	file = std::ifstream(fileName);
 
 	if (!file.good())
@@ -152,6 +229,9 @@ void	CLI::startLogic() const {
 				else
 					break;
 			}
+			// the first number is the size, the smallest map is 3x3
+			if (!resultVector.empty() && resultVector.at(0) < 3)
+				throw CLI_InvalidMap();
 			if (resultVector.size() > 1 && numberCount &&
 				numberCount / resultVector.at(0) != 1)
 				throw CLI_InvalidMap();
@@ -166,12 +246,196 @@ void	CLI::startLogic() const {
 	if (resultVector.size() < 2)
 		throw CLI_InvalidMap();
 
+	mapSize = resultVector[0];
+	map.assign(resultVector.begin() + 1, resultVector.end());
+	if (map.size() != (size_t)mapSize * mapSize)
+		throw CLI_InvalidMap();
+}
+
+void	CLI::startLogic() const {
+	std::vector<int>	map;
+	std::string			fileName;
+	std::string			batch;
+	NP_retVal			result;
+	int					mapSize, heuristic = 0, solutionType = 0, algorithm = A_STAR;
+	int					optimisation = BY_TIME, threads = 0;
+	double				weight = NP_DEFAULT_WEIGHT;
+
+	if (this->getFlag("batch", batch)) {
+		startBatch(batch);
+		return ;
+	}
+
+	this->getFlag("file", fileName);
+	readMap(fileName, mapSize, map);
+
 	this->getFlag("heuristic", heuristic);
 	this->getFlag("solution", solutionType);
-	this->getFlag("optimisation", optimisationByTime);
+	this->getFlag("optimisation", optimisation);
+	this->getFlag("algorithm", algorithm);
+	this->getFlag("threads", threads);
+	this->getFlag("weight", weight);
 
-	mapSize = resultVector[0];
-	for (unsigned i = 1; i < resultVector.size(); i++)
-		map.push_back(resultVector[i]);
-	result = solvePuzzle(map.data(), mapSize, heuristic, solutionType);
+	result = solvePuzzle(map.data(), mapSize, heuristic, solutionType, algorithm, optimisation, weight, threads,
+							getBudget(), isFlagSet("profile"));
+}
+
+// files of the batch: every regular file of the directory, or every line of the list
+static std::vector<std::string>	batchFiles(const std::string &batch) {
+	namespace fs = boost::filesystem;
+	std::vector<std::string>	files;
+
+	if (fs::is_directory(batch)) {
+		for (auto const &entry : fs::directory_iterator(batch))
+			if (fs::is_regular_file(entry.path()))
+				files.push_back(entry.path().string());
+		std::sort(files.begin(), files.end());
+		return (files);
+	}
+
+	std::ifstream	list(batch);
+	std::string		line;
+
+	if (!list.good())
+		throw CLI::CLI_InvalidFile();
+	while (std::getline(list, line)) {
+		line.erase(0, line.find_first_not_of(" \t"));
+		line.erase(line.find_last_not_of(" \t\r") + 1);
+		if (!line.empty() && line[0] != '#')
+			files.push_back(line);
+	}
+	return (files);
+}
+
+static std::string	csvField(const std::string &str) {
+	std::string	res = "\"";
+
+	for (auto c : str) {
+		if (c == '"')
+			res += '"';
+		res += c;
+	}
+	return (res + "\"");
+}
+
+static std::string	jsonString(const std::string &str) {
+	std::string	res = "\"";
+
+	for (auto c : str) {
+		if (c == '"' || c == '\\')
+			res += '\\';
+		res += c;
+	}
+	return (res + "\"");
+}
+
+void	CLI::startBatch(const std::string &batch) const {
+	using clock = std::chrono::steady_clock;
+
+	struct Puzzle {
+		std::string			fileName;
+		std::vector<int>	map;
+		int					mapSize;
+		std::string			error;	// map isn't readable
+	};
+
+	std::vector<Puzzle>		puzzles;
+	std::string				format;
+	int						heuristic = 0, solutionType = 0, algorithm = A_STAR;
+	int						optimisation = BY_TIME, threads = 0;
+	double					weight = NP_DEFAULT_WEIGHT;
+	int						workers = boost::thread::hardware_concurrency();
+	const NP_budget			budget = getBudget();
+
+	this->getFlag("format", format);
+	if (format != "csv" && format != "jsonl")
+		throw CLI_invalidArguments();
+	this->getFlag("heuristic", heuristic);
+	this->getFlag("solution", solutionType);
+	this->getFlag("optimisation", optimisation);
+	this->getFlag("algorithm", algorithm);
+	this->getFlag("threads", threads);
+	this->getFlag("workers", workers);
+	this->getFlag("weight", weight);
+	if (workers < 1)
+		workers = 1;
+
+	// every map is parsed before the solving starts
+	for (auto const &name : batchFiles(batch)) {
+		Puzzle	puzzle;
+
+		puzzle.fileName = name;
+		puzzle.mapSize = 0;
+		try {
+			readMap(name, puzzle.mapSize, puzzle.map);
+		}
+		catch (std::exception &e) {
+			puzzle.error = e.what();
+		}
+		puzzles.push_back(std::move(puzzle));
+	}
+
+	std::atomic<size_t>	next(0);
+	std::mutex			outputMutex;
+	size_t				solved = 0, expanded = 0;
+	const bool			csv = (format == "csv");
+	const auto			start = clock::now();
+
+	if (csv)
+		std::cout << "file,status,length,expanded,generated,memory,time" << std::endl;
+
+	auto	worker = [&]() {
+		NPuzzleSolver	solver;
+
+		solver.setWeight(weight);
+		// puzzles are taken one by one, so long solves don't hold up the rest
+		for (size_t i = next++; i < puzzles.size(); i = next++) {
+			const Puzzle	&puzzle = puzzles[i];
+			NP_retVal		result;
+			std::string		status = puzzle.error;
+
+			if (status.empty()) {
+				try {
+					solver.solve(heuristic, solutionType, puzzle.map.data(), puzzle.mapSize * puzzle.mapSize,
+									result, BUCKET_QUEUE, algorithm, optimisation, threads, budget);
+					status = "solved";
+				}
+				catch (std::exception &e) {
+					status = e.what();
+				}
+			}
+
+			std::stringstream	line;
+
+			if (csv)
+				line << csvField(puzzle.fileName) << "," << csvField(status) << ","
+						<< result.path.size() << "," << result.closedNodes << ","
+						<< result.generatedNodes << "," << result.usedMemory << ","
+						<< result.elapsedTime;
+			else
+				line << "{\"file\":" << jsonString(puzzle.fileName) << ",\"status\":" << jsonString(status)
+						<< ",\"length\":" << result.path.size() << ",\"expanded\":" << result.closedNodes
+						<< ",\"generated\":" << result.generatedNodes << ",\"memory\":" << result.usedMemory
+						<< ",\"time\":" << result.elapsedTime << "}";
+
+			std::lock_guard<std::mutex>	lock(outputMutex);
+			std::cout << line.str() << std::endl;
+			solved += (status == "solved");
+			expanded += result.closedNodes;
+		}
+	};
+
+	boost::thread_group	pool;
+
+	for (int i = 1; i < workers; i++)
+		pool.create_thread(worker);
+	worker();
+	pool.join_all();
+
+	const double	elapsed = std::chrono::duration<double>(clock::now() - start).count();
+
+	std::cerr << "Solved " << solved << " of " << puzzles.size() << " puzzles in "
+				<< elapsed << " sec. by " << workers << " workers" << std::endl
+				<< "Puzzles per second: " << (elapsed > 0 ? puzzles.size() / elapsed : 0) << std::endl
+				<< "Nodes per second: " << (size_t)(elapsed > 0 ? expanded / elapsed : 0) << std::endl;
 }
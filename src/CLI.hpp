@@ -3,6 +3,8 @@
 
 #include <boost/program_options.hpp>
 #include <string>
+#include <vector>
+#include "Budget.hpp"
 
 namespace po = boost::program_options;
 
@@ -11,6 +13,7 @@ class CLI {
 	po::variables_map		vm;
 
 	bool	processArguments(int argc, char **argv);
+	void	startBatch(const std::string &batch) const;
 public:
 	CLI(int argc, char **argv);
 	~CLI();
@@ -19,6 +22,11 @@ public:
 	bool	isFlagSet(const std::string &flag) const;
 	bool	getFlag(const std::string &flag, std::string &result) const;
 	bool	getFlag(const std::string &flag, int &result) const;
+	bool	getFlag(const std::string &flag, double &result) const;
+	NP_budget	getBudget() const;
+
+	// side of the puzzle and its tiles from the file
+	static void	readMap(const std::string &fileName, int &mapSize, std::vector<int> &map);
 
 	class	CLI_invalidArguments : public std::exception {
 	public:
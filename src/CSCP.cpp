@@ -1,91 +1,255 @@
 #include "CSCP.hpp"
+#include "Symmetry.hpp"
 #include "main.hpp"
 
-#define BOOST_SPIRIT_THREADSAFE
-
 #include <boost/filesystem.hpp>
-#include <boost/property_tree/json_parser.hpp>
-#include <boost/property_tree/ptree.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <iostream> //del this
-#include <ctime>
+#include <sstream>
 #include <vector>
 
-void	CSCP::constructTaskResponse(double elapsedTime, NP_retVal &result, std::string &resultStr)
+#define NP_SNAPSHOT_PERIOD	60	// seconds between saves of the solution cache
+
+void	CSCP::constructTaskResponse(NP_retVal &result, std::string &resultStr, bool cached)
 {
-	namespace pt = boost::property_tree;
+	JsonWriter	json(resultStr);
+
+	resultStr.clear();
+	// a move is a few bytes, so the answer is allocated once
+	resultStr.reserve(512 + result.path.size() * 4 + result.improvements.size() * 128);
+	json.beginObject();
+	json.put("messageType", NP_SOLUTION);
+	json.beginObject("data");
+
+	json.beginArray("movements");
+	for (auto const &move: result.path)
+		json.put(nullptr, move);
+	json.endArray();
+
+	json.put("openNodes", result.maxOpen);
+
+	json.put("closedNodes", result.closedNodes);
+
+	json.put("generatedNodes", result.generatedNodes);
 
-	pt::ptree		taskJsonRes;
-	pt::ptree		dataNode;
-	pt::ptree		movesNode;
+	json.put("duplicates", result.duplicates);
 
-	taskJsonRes.put("messageType", NP_SOLUTION);
+	json.put("usedMemory", result.usedMemory);
 
-	for (auto const &move: result.path) {
-		pt::ptree	moveElem;
+	json.put("elapsedTime", result.elapsedTime);
 
-		moveElem.put("", move);
-		movesNode.push_back(std::make_pair("", moveElem));
+	json.put("nodesPerSecond", (size_t)result.nodesPerSecond);
+
+	json.put("cached", cached);
+
+	if (!result.improvements.empty()) {
+		json.beginArray("improvements");
+		for (auto const &improvement : result.improvements) {
+			json.beginObject();
+			json.put("moves", improvement.moves);
+			json.put("bound", improvement.bound);
+			json.put("time", improvement.time);
+			json.put("closedNodes", improvement.expanded);
+			json.endObject();
+		}
+		json.endArray();
 	}
-	dataNode.add_child("movements", movesNode);
 
-	dataNode.put("openNodes", result.maxOpen);
+	if (result.profile.enabled) {
+		json.beginObject("profile");
+		for (int phase = 0; phase < PHASES; phase++) {
+			json.beginObject(NP_profile::name(phase));
+			json.put("time", result.profile.time[phase]);
+			json.put("calls", result.profile.calls[phase]);
+			json.endObject();
+		}
+		json.endObject();
+	}
 
-	dataNode.put("closedNodes", result.closedNodes);
+	json.endObject();
+	json.endObject();
+	json.finish();
+}
 
-	dataNode.put("usedMemory", result.usedMemory);
+void	CSCP::constructBudgetResponse(NPuzzleSolver::NP_BudgetExceeded &e, NP_retVal &result,
+										std::string &resultStr) {
+	static const char	*limitNames[] = {"time", "nodes", "memory", "cancelled"};
+	JsonWriter			json(resultStr);
 
-	dataNode.put("elapsedTime", elapsedTime);
+	resultStr.clear();
+	json.beginObject();
+	json.put("messageType", NP_ERROR);
+	json.beginObject("data");
 
-	taskJsonRes.add_child("data", dataNode);
+	json.put("message", e.what());
 
-	std::stringstream	ss;
-	boost::property_tree::json_parser::write_json(ss, taskJsonRes, false);
-	resultStr = ss.str();
+	json.put("limit", limitNames[e.getLimit()]);
+
+	// stats of the search till the moment it was stopped
+	json.put("closedNodes", result.closedNodes);
+
+	json.put("generatedNodes", result.generatedNodes);
+
+	json.put("usedMemory", result.usedMemory);
+
+	json.put("elapsedTime", result.elapsedTime);
+
+	json.endObject();
+	json.endObject();
+	json.finish();
 }
 
-void	CSCP::constructErrorResponse(std::exception &e, std::string &resultStr) {
-	namespace pt = boost::property_tree;
+static void	putProgress(JsonWriter &json, const char *key, const NP_progress &progress) {
+	json.beginObject(key);
 
-	pt::ptree		taskJsonRes;
-	pt::ptree		dataNode;
+	json.put("closedNodes", progress.expanded);
 
-	taskJsonRes.put("messageType", NP_ERROR);
+	json.put("openNodes", progress.open);
 
-	dataNode.put("message", e.what());
+	json.put("bound", progress.bound);
 
-	taskJsonRes.add_child("data", dataNode);
+	json.put("usedMemory", progress.memory);
 
-	std::stringstream	ss;
-	boost::property_tree::json_parser::write_json(ss, taskJsonRes, false);
-	resultStr = ss.str();
+	json.put("elapsedTime", progress.elapsedTime);
+
+	json.put("nodesPerSecond", (size_t)progress.nodesPerSecond);
+
+	json.endObject();
 }
 
-void	CSCP::taskHandler(boost::property_tree::ptree &json, std::string &resultStr) {
-	namespace pt = boost::property_tree;
+void	CSCP::constructProgressResponse(const NP_progress &progress, std::string &resultStr) {
+	JsonWriter	json(resultStr);
 
-	pt::ptree		mapNode = json.get_child("data.map");
-	pt::ptree		dataNode = json.get_child("data");
-	int				map[mapNode.size()];
-	int				i;
-	clock_t			start;
-	NP_retVal		result;
+	resultStr.clear();
+	json.beginObject();
+	json.put("messageType", NP_PROGRESS);
+	putProgress(json, "data", progress);
+	json.endObject();
+	json.finish();
+}
+
+void	CSCP::constructJobResponse(size_t id, const JobQueue::Info &info, std::string &resultStr) {
+	JsonWriter	json(resultStr);
+
+	resultStr.clear();
+	json.beginObject();
+	json.put("messageType", NP_JOB);
+	json.beginObject("data");
+
+	json.put("id", id);
 
-	result.maxOpen = 0;
-	result.closedNodes = 0;
-	result.usedMemory = 0;
-	pt::ptree::iterator		it = mapNode.begin();
-	for (i = 0; it != mapNode.end(); it++, i++)
-		map[i] = it->second.get<int>("");
+	json.put("status", JobQueue::statusName(info.status));
+
+	if (info.status == JobQueue::QUEUED)
+		json.put("position", info.position);
+
+	if (info.hasProgress)
+		putProgress(json, "progress", info.progress);
+
+	json.endObject();
+	json.endObject();
+	json.finish();
+}
+
+void	CSCP::constructErrorResponse(std::exception &e, std::string &resultStr) {
+	JsonWriter	json(resultStr);
+
+	resultStr.clear();
+	json.beginObject();
+	json.put("messageType", NP_ERROR);
+	json.beginObject("data");
+
+	json.put("message", e.what());
+
+	json.endObject();
+	json.endObject();
+	json.finish();
+}
+
+// limit of the server or of the task, whichever is tighter, 0 means unlimited
+template <typename T>
+static T	tighter(T server, T task) {
+	if (server == 0 || (task != 0 && task < server))
+		return (task);
+	return (server);
+}
+
+void	CSCP::taskHandler(const NP_message &message, std::string &resultStr, const CancelToken &cancel,
+							const NP_budget::ProgressFunc &progress) {
+	message.require(MAP);
+	message.require(HEURISTIC);
+	message.require(SOLUTION_TYPE);
+	message.require(OPTIMISATION);
+
+	const int		*map = message.map.data();
+	NPuzzleSolver	solver;
+	NP_retVal		result;
+	NP_budget		budget;
+	const int		heuristic = message.heuristic;
+	const int		solutionType = message.solutionType;
+	const int		algorithm = message.has(ALGORITHM) ? message.algorithm : A_STAR;
+	const int		optimisation = message.optimisation;
+	const double	weight = message.has(WEIGHT) ? message.weight : NP_DEFAULT_WEIGHT;
+	const bool		profile = message.profile;
+	const int		mapLength = message.map.size();
+	const int		mapSize = std::lround(std::sqrt(mapLength));
+	std::string		key;
+	std::unique_ptr<Symmetry>	symmetry;
+	size_t			transform = 0;
+
+	budget.maxTime = tighter(limits.maxTime, message.maxTime);
+	budget.maxExpanded = tighter(limits.maxExpanded, message.maxNodes);
+	budget.maxMemory = tighter(limits.maxMemory, message.maxMemory);
+	budget.cancel = cancel;
+	budget.progress = progress;
+	solver.setProfiling(profile);
+	solver.setWeight(weight);
+
+	// profiled task wants a real solve, broken maps aren't cached, the solver rejects them
+	if (cache && !profile && mapLength > 0 && mapSize * mapSize == mapLength &&
+		(solutionType == SNAIL_SOLUTION || solutionType == NORMAL_SOLUTION) &&
+		std::all_of(map, map + mapLength, [mapLength](int tile) { return (tile >= 0 && tile < mapLength); })) {
+		auto	start = std::chrono::steady_clock::now();
+		int		canonicalMap[mapLength];
+
+		// symmetric boards share an entry, its path is kept for the canonical board
+		symmetry.reset(new Symmetry(mapSize, solutionType));
+		transform = symmetry->canonical(map, canonicalMap);
+		// the weight changes the path of weighted searches only
+		key = SolutionCache::makeKey(canonicalMap, mapLength, solutionType, heuristic, optimisation, algorithm,
+										optimisation == WEIGHTED || optimisation == ANYTIME ?
+										(int)std::lround(weight * NP_WEIGHT_UNIT) : 0);
+		if (!key.empty() && cache->find(key, result.path)) {
+			symmetry->restorePath(transform, result.path);
+			result.elapsedTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			constructTaskResponse(result, resultStr, true);
+			if (verboseLevel & SERVER)
+				std::cout << "Server send cached response: " << resultStr << std::endl << std::flush;
+			return ;
+		}
+	}
 
 	try {
-		start = clock();
-		optimisationByTime = dataNode.get<int>("optimisation");
-		this->solver.solve(dataNode.get<int>("heuristicFunction"),
-							dataNode.get<int>("solutionType"),
-							map, mapNode.size(),
-							result);
-		start = clock() - start;
-		constructTaskResponse((double)start / CLOCKS_PER_SEC, result, resultStr);
+		solver.solve(heuristic, solutionType,
+						map, mapLength,
+						result, BUCKET_QUEUE,
+						algorithm,
+						optimisation,
+						message.threads,
+						budget);
+		// anytime search stopped by the budget may find a better path next time
+		if (!key.empty() && (result.improvements.empty() || result.improvements.back().bound <= 1.0)) {
+			std::list<int>	path(result.path);
+
+			symmetry->turnPath(transform, path);
+			cache->insert(key, path);
+		}
+		constructTaskResponse(result, resultStr);
+	}
+	catch (NPuzzleSolver::NP_BudgetExceeded &e) {
+		constructBudgetResponse(e, result, resultStr);
 	}
 	catch (std::exception &e) {
 		constructErrorResponse(e, resultStr);
@@ -96,21 +260,71 @@ void	CSCP::taskHandler(boost::property_tree::ptree &json, std::string &resultStr
 					<< std::endl << std::flush;
 }
 
-void	CSCP::processMessage(boost::property_tree::ptree &json, std::string &resultStr) {
-	namespace pt = boost::property_tree;
+// the task waits in the queue of jobs, its answer is taken by NP_FETCH
+void	CSCP::submitHandler(const NP_message &message, std::string &resultStr) {
+	NP_message	task = message;
+	size_t		id;
+
+	message.require(MAP);
+	message.require(SOLUTION_TYPE);
+	task.messageType = NP_TASK;
+	id = jobs.submit(task, message.priority,
+						JobQueue::difficulty(message.map.data(), message.map.size(), message.solutionType));
+	// every job gets a turn of a worker, the job which runs is chosen then
+	solvers.post([this]() { runJob(); });
+	constructJobResponse(id, jobs.status(id), resultStr);
+}
+
+void	CSCP::jobHandler(const NP_message &message, std::string &resultStr) {
+	const size_t	id = message.id;
+	JobQueue::Info	info;
+
+	message.require(JOB_ID);
+	if (message.messageType == NP_STATUS)
+		info = jobs.status(id);
+	else if (message.messageType == NP_CANCEL)
+		info = jobs.cancel(id);
+	else
+		info = jobs.fetch(id);
+	// the answer is given once, by NP_FETCH
+	if (message.messageType == NP_FETCH && info.status == JobQueue::DONE)
+		resultStr = info.answer;
+	else
+		constructJobResponse(id, info, resultStr);
+}
 
-	int		messageType = json.get<int>("messageType");
+void	CSCP::runJob() {
+	std::shared_ptr<JobQueue::Job>	job = jobs.next();
 
-	if (verboseLevel & SERVER) {
-		std::stringstream	ss;
-		boost::property_tree::json_parser::write_json(ss, json, false);
-		std::cout << "Server receive request: " << ss.str() << std::endl;
-	}
+	// a heavy job waits for a free worker of heavy jobs, the next turn comes when one is done
+	if (!job)
+		return ;
 
-	switch (messageType) {
+	std::string						answer;
+	const size_t					id = job->id;
+
+	processMessage(job->task, answer, job->cancel,
+					[this, id](const NP_progress &progress) { jobs.progress(id, progress); });
+	jobs.done(job, answer);
+	solvers.post([this]() { runJob(); });
+}
+
+void	CSCP::processMessage(const NP_message &message, std::string &resultStr, const CancelToken &cancel,
+								const NP_budget::ProgressFunc &progress) {
+	switch (message.messageType) {
 		case NP_TASK:
-			try {taskHandler(json, resultStr);}
-			catch (std::exception &e) {}
+			try {taskHandler(message, resultStr, cancel, progress);}
+			catch (std::exception &e) {constructErrorResponse(e, resultStr);}
+			break;
+		case NP_SUBMIT:
+			try {submitHandler(message, resultStr);}
+			catch (std::exception &e) {constructErrorResponse(e, resultStr);}
+			break;
+		case NP_STATUS:
+		case NP_FETCH:
+		case NP_CANCEL:
+			try {jobHandler(message, resultStr);}
+			catch (std::exception &e) {constructErrorResponse(e, resultStr);}
 			break;
 		default:
 			CSCP_InvalidMessageType	e;
@@ -119,31 +333,200 @@ void	CSCP::processMessage(boost::property_tree::ptree &json, std::string &result
 	}
 }
 
-void	CSCP::serverInit() {
-	using HttpServer = SimpleWeb::Server<SimpleWeb::HTTP>;
+// chunk of the chunked transfer encoding, the empty one ends the answer
+static std::string	chunk(const std::string &data) {
+	std::stringstream	ss;
+
+	ss << std::hex << data.size() << "\r\n" << data << "\r\n";
+	return (ss.str());
+}
+
+// server-sent event, every line of the data is a field of its own
+static std::string	event(const std::string &name, const std::string &data) {
+	std::stringstream	ss(data);
+	std::string			res = "event: " + name + "\n";
+	std::string			line;
+
+	while (std::getline(ss, line))
+		res += "data: " + line + "\n";
+	return (res + "\n");
+}
+
+// the message is parsed from the text of the request, no tree of it is built
+void	CSCP::receive(const std::shared_ptr<HttpServer::Request> &request, NP_message &message) {
+	const std::string	body = request->content.string();
+
+	if (verboseLevel & SERVER)
+		std::cout << "Server receive request: " << body << std::endl;
+	JsonCodec::parse(body, message);
+}
+
+void	CSCP::startTask(const std::shared_ptr<HttpServer::Response> &response, const NP_message &message,
+						bool events) {
+	auto							task = std::make_shared<Task>(response, *server.io_service, events);
+	SimpleWeb::CaseInsensitiveMultimap	header;
+	NP_budget::ProgressFunc			progress;
+
+	header.emplace("Content-Type", events ? "text/event-stream" : "application/json");
+	header.emplace("Cache-Control", "no-cache");
+	header.emplace("Transfer-Encoding", "chunked");
+	response->write(header);
+
+	// only the latest progress is kept, a slow client skips the older ones
+	if (events)
+		progress = [this, task](const NP_progress &state) {
+			std::string	frame;
+
+			constructProgressResponse(state, frame);
+			server.io_service->post([this, task, frame]() {
+				std::lock_guard<std::mutex>	lock(task->mutex);
+
+				if (task->finished)
+					return ;
+				task->progress = frame;
+				sendProgress(task);
+			});
+		};
+
+	solvers.post([this, task, message, progress]() {
+		std::string	answer;
+
+		processMessage(message, answer, task->cancel, progress);
+		// the response is written by threads of the server only
+		server.io_service->post([this, task, answer]() {
+			std::lock_guard<std::mutex>	lock(task->mutex);
+
+			task->finished = true;
+			task->answer = answer;
+			task->heartbeat.cancel();
+			if (!task->sending)
+				sendAnswer(task);
+		});
+	});
+	std::lock_guard<std::mutex>	lock(task->mutex);
+	beat(task);
+}
 
+// task->mutex is locked
+void	CSCP::beat(const std::shared_ptr<Task> &task) {
+	task->heartbeat.expires_from_now(std::chrono::seconds(1));
+	task->heartbeat.async_wait([this, task](const boost::system::error_code &ec) {
+		std::lock_guard<std::mutex>	lock(task->mutex);
+
+		if (ec || task->finished)
+			return ;
+		// JSON allows leading spaces, so the answer stays valid, events have comments
+		if (!task->sending) {
+			*task->response << chunk(task->events ? ":\n\n" : " ");
+			task->sending = true;
+			task->response->send([this, task](const SimpleWeb::error_code &ec) { sent(task, ec); });
+		}
+		beat(task);
+	});
+}
+
+// task->mutex is locked
+void	CSCP::sendProgress(const std::shared_ptr<Task> &task) {
+	if (task->sending || task->progress.empty() || task->cancel->load())
+		return ;
+	*task->response << chunk(event("progress", task->progress));
+	task->progress.clear();
+	task->sending = true;
+	task->response->send([this, task](const SimpleWeb::error_code &ec) { sent(task, ec); });
+}
+
+// task->mutex is locked
+void	CSCP::sendAnswer(const std::shared_ptr<Task> &task) {
+	task->answered = true;
+	if (task->cancel->load())
+		return ;
+	*task->response << chunk(task->events ? event("result", task->answer) : task->answer) << chunk("");
+	task->sending = true;
+	task->response->send([this, task](const SimpleWeb::error_code &ec) { sent(task, ec); });
+}
+
+void	CSCP::sent(const std::shared_ptr<Task> &task, const SimpleWeb::error_code &ec) {
+	std::lock_guard<std::mutex>	lock(task->mutex);
+
+	task->sending = false;
+	if (ec) {
+		// client has closed the connection, nobody needs the solve anymore
+		task->cancel->store(true);
+		if (verboseLevel & SERVER)
+			std::cout << "Client is gone, task is cancelled" << std::endl;
+		return ;
+	}
+	if (task->finished && !task->answered)
+		sendAnswer(task);
+	else if (!task->finished)
+		sendProgress(task);
+}
+
+void	CSCP::serverInit() {
 	server.config.port = 8080;
+	// tasks are solved by their own threads, the server only reads and writes
+	server.config.thread_pool_size = 1;
 
 	server.resource["^/message$"]["POST"] = [this](std::shared_ptr<HttpServer::Response> response, std::shared_ptr<HttpServer::Request> request) {
 		try {
-			namespace pt = boost::property_tree;
-			std::string	result;
-			pt::ptree	json;
+			NP_message	message;
+
+			receive(request, message);
+			// messages of jobs are answered at once, they don't wait for a solver
+			if (message.messageType == NP_TASK)
+				startTask(response, message, false);
+			else {
+				SimpleWeb::CaseInsensitiveMultimap	header;
+				std::string							answer;
+
+				processMessage(message, answer);
+				header.emplace("Content-Type", "application/json");
+				response->write(SimpleWeb::StatusCode::success_ok, answer, header);
+			}
+		}
+		catch(const std::exception &e) {
+			// construct json error here
+			*response << "HTTP/1.1 400 Bad Request\r\nContent-Length: " << strlen(e.what()) << "\r\n\r\n"
+						<< e.what();
+		}
+	};
 
-			read_json(request->content, json);
-			processMessage(json, result);
+	// the same task, its answer is a stream of progress events and the 'result' event
+	server.resource["^/stream$"]["POST"] = [this](std::shared_ptr<HttpServer::Response> response, std::shared_ptr<HttpServer::Request> request) {
+		try {
+			NP_message	message;
 
-			*response << "HTTP/1.1 200 OK\r\n"
-						<< "Content-Length: " << result.length() << "\r\n\r\n"
-						<< result;
+			receive(request, message);
+			startTask(response, message, true);
 		}
 		catch(const std::exception &e) {
-			// construct json error here
 			*response << "HTTP/1.1 400 Bad Request\r\nContent-Length: " << strlen(e.what()) << "\r\n\r\n"
 						<< e.what();
 		}
 	};
 
+	server.resource["^/cache$"]["GET"] = [this](std::shared_ptr<HttpServer::Response> response, std::shared_ptr<HttpServer::Request> /*request*/) {
+		std::string	answer;
+		JsonWriter	json(answer);
+
+		json.beginObject();
+		json.put("enabled", cache != nullptr);
+		if (cache) {
+			json.put("entries", cache->size());
+			json.put("usedMemory", cache->usedMemory());
+			json.put("capacity", cache->getCapacity());
+			json.put("hits", cache->getHits());
+			json.put("misses", cache->getMisses());
+		}
+		json.endObject();
+		json.finish();
+
+		SimpleWeb::CaseInsensitiveMultimap	header;
+
+		header.emplace("Content-Type", "application/json");
+		response->write(SimpleWeb::StatusCode::success_ok, answer, header);
+	};
+
 	server.default_resource["GET"] = [](std::shared_ptr<HttpServer::Response> response, std::shared_ptr<HttpServer::Request> request) {
 		try {
 			auto web_root_path = boost::filesystem::canonical("webPages");
@@ -167,19 +550,22 @@ void	CSCP::serverInit() {
 				header.emplace("Content-Length", to_string(length));
 				response->write(header);
 
+				// buffer belongs to the response, server runs on several threads
+				auto buffer = std::make_shared<std::vector<char>>(131072);
+
 				// Trick to define a recursive function within this scope (for example purposes)
 				class FileServer {
 					public:
-					static void read_and_send(const std::shared_ptr<HttpServer::Response> &response, const std::shared_ptr<std::ifstream> &ifs) {
+					static void read_and_send(const std::shared_ptr<HttpServer::Response> &response, const std::shared_ptr<std::ifstream> &ifs,
+											const std::shared_ptr<std::vector<char>> &buffer) {
 						// Read and send 128 KB at a time
-						static std::vector<char> buffer(131072); // Safe when server is running on one thread
 						std::streamsize read_length;
-						if((read_length = ifs->read(&buffer[0], static_cast<std::streamsize>(buffer.size())).gcount()) > 0) {
-							response->write(&buffer[0], read_length);
-							if(read_length == static_cast<std::streamsize>(buffer.size())) {
-								response->send([response, ifs](const SimpleWeb::error_code &ec) {
+						if((read_length = ifs->read(&(*buffer)[0], static_cast<std::streamsize>(buffer->size())).gcount()) > 0) {
+							response->write(&(*buffer)[0], read_length);
+							if(read_length == static_cast<std::streamsize>(buffer->size())) {
+								response->send([response, ifs, buffer](const SimpleWeb::error_code &ec) {
 									if(!ec)
-										read_and_send(response, ifs);
+										read_and_send(response, ifs, buffer);
 									else
 										std::cerr << "Connection interrupted" << std::endl;
 								});
@@ -187,7 +573,7 @@ void	CSCP::serverInit() {
 						}
 					}
 				};
-				FileServer::read_and_send(response, ifs);
+				FileServer::read_and_send(response, ifs, buffer);
 			}
 			else
 				throw std::invalid_argument("could not read file");
@@ -213,9 +599,46 @@ boost::thread	*CSCP::serverStart() {
 	return (server_thread);
 }
 
-CSCP::CSCP() {
+void	CSCP::saveCache() {
+	try {
+		cache->save(cacheFile);
+	}
+	catch (std::exception &e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+	}
+}
+
+// snapshot is saved by a solver thread, so the server doesn't wait for the disk
+void	CSCP::scheduleSnapshot() {
+	std::lock_guard<std::mutex>	lock(snapshotMutex);
+
+	if (stopping)
+		return ;
+	snapshotTimer.expires_from_now(std::chrono::seconds(NP_SNAPSHOT_PERIOD));
+	snapshotTimer.async_wait([this](const boost::system::error_code &ec) {
+		if (ec)
+			return ;
+		saveCache();
+		scheduleSnapshot();
+	});
+}
+
+CSCP::CSCP(size_t threads, const NP_budget &limits, size_t cacheCapacity, const std::string &cacheFile)
+	: solversWork(new boost::asio::io_service::work(solvers)), limits(limits), jobs(threads), cacheFile(cacheFile),
+	snapshotTimer(solvers), stopping(false)
+{
 	try {
+		if (cacheCapacity > 0) {
+			cache.reset(new SolutionCache(cacheCapacity));
+			if (!cacheFile.empty()) {
+				if (cache->load(cacheFile) && (verboseLevel & SERVER))
+					std::cout << "Solution cache loaded: " << cache->size() << " answers" << std::endl;
+				scheduleSnapshot();
+			}
+		}
 		serverInit();
+		for (size_t i = 0; i < threads; i++)
+			solverThreads.create_thread([this]{ solvers.run(); });
 	}
 	catch (std::exception &e) {
 		std::cerr << "Unhandled exception: " << e.what() << std::endl;
@@ -223,5 +646,17 @@ CSCP::CSCP() {
 }
 
 CSCP::~CSCP() {
+	server.stop();
+	{
+		std::lock_guard<std::mutex>	lock(snapshotMutex);
 
+		stopping = true;
+		snapshotTimer.cancel();
+	}
+	// queued jobs aren't started, so the solvers are done soon
+	jobs.close();
+	solversWork.reset();
+	solverThreads.join_all();
+	if (cache && !cacheFile.empty())
+		saveCache();
 }
@@ -4,31 +4,100 @@
 #define BOOST_SPIRIT_THREADSAFE
 
 #include <server_http.hpp>
-#include <boost/property_tree/ptree.hpp>
+#include <boost/asio.hpp>
 #include <boost/thread.hpp>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include "JobQueue.hpp"
+#include "JsonCodec.hpp"
 #include "NPuzzleSolver.hpp"
+#include "SolutionCache.hpp"
 
 typedef enum MessageType_e {
 	NP_TASK,
 	NP_SOLUTION,
-	NP_ERROR
+	NP_ERROR,
+	NP_PROGRESS,
+	NP_SUBMIT,		// task for the queue of jobs
+	NP_STATUS,		// the following ones take id of the job
+	NP_FETCH,
+	NP_CANCEL,
+	NP_JOB			// id and status of a job
 } MessageType_E;
 
 class CSCP {
-	SimpleWeb::Server<SimpleWeb::HTTP>	server;
-	NPuzzleSolver						solver;
+	typedef SimpleWeb::Server<SimpleWeb::HTTP>	HttpServer;
+	typedef std::shared_ptr<std::atomic<bool>>	CancelToken;
 
-	void	constructTaskResponse(double elapsedTime, NP_retVal &result, std::string &resultStr);
+	/*
+	 * Request which is being solved. Its answer is chunked: while the solve goes on
+	 * client gets a space every second, failed write means the client is gone.
+	 * Answer of /stream is server-sent events: progress of the solve and the answer.
+	 */
+	struct Task {
+		std::shared_ptr<HttpServer::Response>	response;
+		CancelToken								cancel;
+		boost::asio::steady_timer				heartbeat;
+		const bool								events;		// answer is a stream of events
+		std::mutex								mutex;		// guards the fields below and the response
+		bool									sending;	// write to the client isn't finished yet
+		bool									finished;	// answer is ready
+		bool									answered;	// answer is written
+		std::string								answer;
+		std::string								progress;	// the latest progress which isn't written
+
+		Task(const std::shared_ptr<HttpServer::Response> &response, boost::asio::io_service &io, bool events)
+			: response(response), cancel(new std::atomic<bool>(false)), heartbeat(io), events(events),
+			sending(false), finished(false), answered(false) {};
+	};
+
+	HttpServer								server;
+	boost::asio::io_service					solvers;	// queue of tasks
+	std::unique_ptr<boost::asio::io_service::work>	solversWork;
+	boost::thread_group						solverThreads;
+	NP_budget								limits;		// budget of every task
+	JobQueue								jobs;		// run by the threads of 'solvers'
+	std::unique_ptr<SolutionCache>			cache;		// nullptr if disabled
+	std::string								cacheFile;	// snapshot of the cache, saved by solvers
+	boost::asio::steady_timer				snapshotTimer;
+	std::mutex								snapshotMutex;	// guards the timer and 'stopping'
+	bool									stopping;
+
+	void	constructTaskResponse(NP_retVal &result, std::string &resultStr, bool cached = false);
 	void	constructErrorResponse(std::exception &e, std::string &resultStr);
-	void	taskHandler(boost::property_tree::ptree &json, std::string &resultStr);
+	void	constructBudgetResponse(NPuzzleSolver::NP_BudgetExceeded &e, NP_retVal &result,
+									std::string &resultStr);
+	void	constructProgressResponse(const NP_progress &progress, std::string &resultStr);
+	void	constructJobResponse(size_t id, const JobQueue::Info &info, std::string &resultStr);
+	void	taskHandler(const NP_message &message, std::string &resultStr, const CancelToken &cancel,
+						const NP_budget::ProgressFunc &progress);
+	void	submitHandler(const NP_message &message, std::string &resultStr);
+	void	jobHandler(const NP_message &message, std::string &resultStr);
+	void	runJob();
 	void	serverInit();
+	void	receive(const std::shared_ptr<HttpServer::Request> &request, NP_message &message);
+	void	startTask(const std::shared_ptr<HttpServer::Response> &response, const NP_message &message,
+						bool events);
+	void	beat(const std::shared_ptr<Task> &task);
+	void	sendProgress(const std::shared_ptr<Task> &task);
+	void	sendAnswer(const std::shared_ptr<Task> &task);
+	void	sent(const std::shared_ptr<Task> &task, const SimpleWeb::error_code &ec);
+	void	scheduleSnapshot();
+	void	saveCache();
 
 public:
-	CSCP();
+	// 'threads' solve tasks, every one solves its own task
+	// answers are cached in 'cacheCapacity' bytes, 0 disables the cache
+	explicit CSCP(size_t threads = 1, const NP_budget &limits = NP_budget(), size_t cacheCapacity = 0,
+					const std::string &cacheFile = "");
 	~CSCP();
 
 	boost::thread	*serverStart();
-	void			processMessage(boost::property_tree::ptree &json, std::string &result);
+	// 'progress' gets progress of the solve, see NP_budget
+	void			processMessage(const NP_message &message, std::string &result,
+									const CancelToken &cancel = nullptr,
+									const NP_budget::ProgressFunc &progress = NP_budget::ProgressFunc());
 
 	class	CSCP_InvalidMessageType : public std::exception {
 	public:
@@ -1,79 +1,187 @@
 #include "Heuristic.hpp"
 #include "State.hpp"
+#include "PatternDatabase.hpp"
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include <functional>
 
-auto findIndexByValue = [](int value, const int *map, const int mapLength) {
+void	Heuristic::initTables(const int *finishMap, int mapSize) {
+	this->mapSize = mapSize;
+	this->mapLength = mapSize * mapSize;
+	goalIndex.assign(mapLength, 0);
+	goalRow.assign(mapLength, 0);
+	goalCol.assign(mapLength, 0);
+	distances.assign(mapLength * mapLength, 0);
+
+	for (int i = 0; i < mapLength; i++) {
+		goalIndex[finishMap[i]] = i;
+		goalRow[finishMap[i]] = i / mapSize;
+		goalCol[finishMap[i]] = i % mapSize;
+	}
+
+	// the empty piece doesn't count, its row stays zero
+	for (int tile = 1; tile < mapLength; tile++) {
+		for (int i = 0; i < mapLength; i++) {
+			distances[tile * mapLength + i] = std::abs(i / mapSize - goalRow[tile]) +
+												std::abs(i % mapSize - goalCol[tile]);
+		}
+	}
+}
+
+void	Heuristic::initPatterns(const int *finishMap, int mapSize, int solutionType) {
+	patterns = PatternDatabase::get(finishMap, mapSize, solutionType);
+	tilePattern.assign(mapSize * mapSize, 0);
+	for (size_t i = 0; i < patterns.size(); i++)
+		for (int tile : patterns[i]->getTiles())
+			tilePattern[tile] = i;
+}
+
+bool	Heuristic::initReversed(const Heuristic &forward, const int *finishMap, const int *goalMap) {
+	initTables(goalMap, forward.mapSize);
+	patterns.clear();
+	rename.clear();
+	if (forward.patterns.empty() ||
+		std::find(goalMap, goalMap + mapLength, 0) - goalMap != std::find(finishMap, finishMap + mapLength, 0) - finishMap)
+		return (false);
+
+	patterns = forward.patterns;
+	tilePattern = forward.tilePattern;
+	rename.resize(mapLength);
 	for (int i = 0; i < mapLength; i++)
-		if (map[i] == value)
-			return (i);
-	return (-1);
-};
-
-int	Heuristic::misplacedTiles(const State *state) {
-	const int	*finishMap = state->finishState->getMapPtr();
-	const int	*map = state->getMapPtr();
-	int			inversions = 0;
+		rename[goalMap[i]] = finishMap[i];
+	return (true);
+}
 
-	for (int i = 0; i < State::mapLength; i++) {
-		if (map[i] != finishMap[i])
-			inversions++;
+// two tiles stand on the finish places of each other
+template <typename Board>
+static inline bool	isSwapped(const Board &map, const int *goalIndex, int a, int b) {
+	const int	tileA = map.get(a);
+	const int	tileB = map.get(b);
+
+	return (tileA && tileB && goalIndex[tileA] == b && goalIndex[tileB] == a);
+}
+
+// conflicts of 'tile' placed at 'pos' with tiles in the same row and column, 'skip' is ignored
+template <typename Board>
+static inline int	tileConflicts(const Board &map, const int *goalIndex, int tile, int pos, int skip,
+								int mapSize) {
+	const int	goal = goalIndex[tile];
+	int			other;
+
+	// only the tile which stands on the finish place of 'tile' can conflict with it
+	if (goal == pos || goal == skip ||
+		(goal / mapSize != pos / mapSize && goal % mapSize != pos % mapSize))
+		return (0);
+	return ((other = map.get(goal)) && goalIndex[other] == pos);
+}
+
+// cost of nMaxSwap cycles which go through places 'a' and 'b'
+template <typename TileAt>
+static int	cyclesCost(TileAt tileAt, const int *goalIndex, int a, int b) {
+	const int	starts[] = {a, b};
+	bool		bVisited = false;
+	int			cost = 0;
+
+	for (int start : starts) {
+		int		cycleLength = 0;
+		bool	withEmpty = false;
+		int		j = start;
+
+		if (start == b && bVisited)
+			break;
+		do {
+			if (j == b)
+				bVisited = true;
+			if (tileAt(j) == 0)
+				withEmpty = true;
+			cycleLength++;
+			j = goalIndex[tileAt(j)];
+		} while (j != start);
+
+		if (cycleLength > 1)
+			cost += withEmpty ? cycleLength - 1 : cycleLength + 1;
 	}
-	return (inversions);
+	return (cost);
 }
 
-int	Heuristic::manhattanDistance(const State *state) {
-	const int	*finishMap = state->finishState->getMapPtr();
-	const int	*map = state->getMapPtr();
-	int			price = 0;
-	int			x1, x2, y1, y2, xres, yres, j;
+/*
+ * *Diff functions return the change of heuristic after 'tile' was moved
+ * 'from' -> 'to' in the state, so 'from' already holds the empty piece.
+ */
 
-	for (int i = 0; i < State::mapLength; i++) {
-		if (map[i]) {
-			x1 = i % State::mapSize;
-			y1 = i / State::mapSize;
+template <typename Board>
+int	Heuristic::misplacedTilesDiff(const State<Board> *state, int tile, int from, int to) const {
+	const int	*goal = goalIndex.data();
 
-			j = findIndexByValue(map[i], finishMap, State::mapLength);
+	return ((goal[0] != from) + (goal[tile] != to) - (goal[tile] != from) - (goal[0] != to));
+}
 
-			x2 = j % State::mapSize;
-			y2 = j / State::mapSize;
+template <typename Board>
+int	Heuristic::manhattanDistanceDiff(const State<Board> *state, int tile, int from, int to) const {
+	const int	*tileDistances = distances.data() + tile * mapLength;
 
-			if ((xres = x1 - x2) < 0)
-				xres *= -1;
+	return (tileDistances[to] - tileDistances[from]);
+}
 
-			if ((yres = y1 - y2) < 0)
-				yres *= -1;
+template <typename Board>
+int	Heuristic::linearConflictsDiff(const State<Board> *state, int tile, int from, int to) const {
+	const Board	&map = state->board;
+	const int	*goal = goalIndex.data();
 
-			price += xres + yres;
-		}
+	// in the parent 'to' was empty, so skip it when count old conflicts
+	return (tileConflicts(map, goal, tile, to, -1, mapSize) -
+			tileConflicts(map, goal, tile, from, to, mapSize));
+}
+
+template <typename Board>
+int	Heuristic::misplacedTiles(const State<Board> *state) const {
+	const Board	&map = state->board;
+	const int	*goal = goalIndex.data();
+	int			inversions = 0;
+
+	for (int i = 0; i < mapLength; i++) {
+		if (goal[map.get(i)] != i)
+			inversions++;
 	}
+	return (inversions);
+}
+
+template <typename Board>
+int	Heuristic::manhattanDistance(const State<Board> *state) const {
+	const int	*table = distances.data();
+	int			map[mapLength];
+	int			price = 0;
+
+	state->board.unpack(map, mapLength);
+	for (int i = 0; i < mapLength; i++)
+		price += table[map[i] * mapLength + i];
 
 	return (price);
 }
 
-int	Heuristic::linearConflicts(const State *state) {
-	const int	*finishMap = state->finishState->getMapPtr();
-	const int	*map = state->getMapPtr();
+template <typename Board>
+int	Heuristic::linearConflicts(const State<Board> *state) const {
+	const Board	&map = state->board;
+	const int	*goal = goalIndex.data();
 	int			linearConflicts = 0;
 
 	// conflicts in rows
-	for (int row = 0; row < State::mapSize; row++) {
-		for (int x1 = row * State::mapSize; x1 < row + State::mapSize; x1++) {
-			for (int x2 = x1 + 1; x2 < row + State::mapSize; x2++) {
-				if (map[x1] != finishMap[x1] && map[x2] != finishMap[x2] &&
-					(map[x1] == finishMap[x2] && map[x2] == finishMap[x1]))
-							linearConflicts++;
+	for (int row = 0; row < mapLength; row += mapSize) {
+		for (int x1 = row; x1 < row + mapSize; x1++) {
+			for (int x2 = x1 + 1; x2 < row + mapSize; x2++) {
+				if (isSwapped(map, goal, x1, x2))
+					linearConflicts++;
 			}
 		}
 	}
 
 	// conflicts in columns
-	for (int col = 0; col < State::mapSize; col++) {
-		for (int y1 = col; y1 < col + State::mapSize * (State::mapSize - 1); y1 += State::mapSize) {
-			for (int y2 = col + State::mapSize; y2 < col + State::mapSize * (State::mapSize - 1); y2 += State::mapSize) {
-				if (map[y1] != finishMap[y1] && map[y2] != finishMap[y2] &&
-					(map[y1] == finishMap[y2] && map[y2] == finishMap[y1]))
-							linearConflicts++;
+	for (int col = 0; col < mapSize; col++) {
+		for (int y1 = col; y1 < mapLength; y1 += mapSize) {
+			for (int y2 = y1 + mapSize; y2 < mapLength; y2 += mapSize) {
+				if (isSwapped(map, goal, y1, y2))
+					linearConflicts++;
 			}
 		}
 	}
@@ -81,119 +189,150 @@ int	Heuristic::linearConflicts(const State *state) {
 	return (linearConflicts);
 }
 
-int	Heuristic::MDplusLinearConflicts(const State *state) {
+template <typename Board>
+int	Heuristic::MDplusLinearConflicts(const State<Board> *state) const {
 	return (manhattanDistance(state) + linearConflicts(state));
 }
 
-int	Heuristic::MTplusLinearConflicts(const State *state) {
+template <typename Board>
+int	Heuristic::MTplusLinearConflicts(const State<Board> *state) const {
 	return (misplacedTiles(state) + linearConflicts(state));
 }
 
-// int	Heuristic::nMaxSwap(const State *state) {
-// 	const int	*finishMap = state->finishState->getMapPtr();
-// 	const int	*map = state->getMapPtr();
-// 	int	mapCopy[State::mapLength];
-// 	int	retVal = 0;
-// 	int	zeroI = 0;
-//
-// 	for (int i = 0; i < State::mapLength; i++)
-// 		mapCopy[i] = map[i];
-//
-// 	for (int i = 0; i < State::mapLength; i++) {
-// 		if (mapCopy[i] != finishMap[i]) {
-// 			zeroI = findIndexByValue(0, mapCopy, State::mapLength);
-// 			if (i != zeroI) {
-// 				retVal++;
-// 				std::swap(mapCopy[i], mapCopy[zeroI]);
-// 				zeroI = i;
-// 			}
-// 			else {
-// 				int j = findIndexByValue(finishMap[i], mapCopy, State::mapLength);
-// 				std::swap(mapCopy[j], mapCopy[zeroI]);
-// 				retVal++;
-// 			}
-// 		}
-// 	}
-//
-// 	// for (int i = 0; i < State::mapLength; i++) {
-// 	// 	zeroI = findIndexByValue(0, mapCopy, State:mapLength);
-// 	// 	if (zeroI != i)
-// 	// }
-//
-// 	// std::cout << __func__ << " ##### ";
-// 	// for (int i = 0; i < State::mapLength; i++) {
-// 	// 	if (i % State::mapSize == 0)
-// 	// 		std::cout << std::endl << mapCopy[i] << " ";
-// 	// 	else
-// 	// 		std::cout << mapCopy[i] << " ";
-// 	// }
-// 	// std::cout << std::endl;
-//
-// 	return (retVal);
-// }
-
-
-
-
-
-
-
-
-
-
-
-
-
-int	Heuristic::nMaxSwap(const State *state) {
-	const int	*finishMap = state->finishState->getMapPtr();
-	const int	*map = state->getMapPtr();
-	int	mapCopy[State::mapLength];
-	int	retVal = 0;
-	int	zeroI = 0;
-	auto misplaced = [&mapCopy, &finishMap]() {
-		for (int i = 0; i < State::mapLength; i++) {
-			if (mapCopy[i] != finishMap[i])
-				return (1);
-		}
-		return (0);
-	};
+/*
+ * Gaschnig's heuristic: amount of swaps with the empty piece to reach finish state.
+ * Every cycle of misplaced tiles costs (length + 1) swaps,
+ * cycle with the empty piece costs (length - 1) swaps.
+ */
+template <typename Board>
+int	Heuristic::nMaxSwap(const State<Board> *state) const {
+	const Board	&map = state->board;
+	const int	*goal = goalIndex.data();
+	bool		visited[mapLength];
+	int			retVal = 0;
 
-	for (int i = 0; i < State::mapLength; i++)
-		mapCopy[i] = map[i];
+	for (int i = 0; i < mapLength; i++)
+		visited[i] = false;
 
-	while (misplaced()) {
-		zeroI = findIndexByValue(0, mapCopy, State::mapLength);
-		// zero is not on right place
-		if (zeroI != findIndexByValue(0, finishMap, State::mapLength)) {
-			int swapI = findIndexByValue(finishMap[zeroI], mapCopy, State::mapLength);
-			std::swap(mapCopy[zeroI], mapCopy[swapI]);
-			retVal++;
-		}
-		else {
-			for (int i = 1; i < State::mapLength - 1; i++)
-				if (findIndexByValue(i, mapCopy, State::mapLength) !=
-					findIndexByValue(i, finishMap, State::mapLength)) {
-						int swapI = findIndexByValue(i, mapCopy, State::mapLength);
-						std::swap(mapCopy[zeroI], mapCopy[swapI]);
-						retVal++;
-						break;
-					}
+	for (int i = 0; i < mapLength; i++) {
+		int		cycleLength = 0;
+		bool	withEmpty = false;
+
+		for (int j = i; !visited[j]; j = goal[map.get(j)]) {
+			visited[j] = true;
+			cycleLength++;
+			if (j == state->blank)
+				withEmpty = true;
 		}
+		if (cycleLength > 1)
+			retVal += withEmpty ? cycleLength - 1 : cycleLength + 1;
 	}
 
-	// for (int i = 0; i < State::mapLength; i++) {
-	// 	if (mapCopy[i] != finishMap[i]) {
-	// 		std::cout << __func__ << " ##### ";
-	// 		for (int i = 0; i < State::mapLength; i++) {
-	// 			if (i % State::mapSize == 0)
-	// 				std::cout << std::endl << mapCopy[i] << " ";
-	// 			else
-	// 				std::cout << mapCopy[i] << " ";
-	// 		}
-	// 		std::cout << std::endl;
-	// 		break;
-	// 	}
-	// }
+	return (retVal);
+}
+
+// sum of disjoint patterns, every tile belongs to exactly one of them
+template <typename Board>
+int	Heuristic::patternDatabase(const State<Board> *state) const {
+	const Board	&map = state->board;
+	int			tilePlaces[mapLength];
+	int			retVal = 0;
 
+	if (rename.empty()) {
+		for (int i = 0; i < mapLength; i++)
+			tilePlaces[map.get(i)] = i;
+	}
+	else {
+		for (int i = 0; i < mapLength; i++)
+			tilePlaces[rename[map.get(i)]] = i;
+	}
+	for (auto const &pattern : patterns)
+		retVal += pattern->value(tilePlaces);
 	return (retVal);
 }
+
+template <typename Board>
+int	Heuristic::misplacedTilesDelta(const State<Board> *state, int price, int tile, int from, int to) const {
+	return (price + misplacedTilesDiff(state, tile, from, to));
+}
+
+template <typename Board>
+int	Heuristic::manhattanDistanceDelta(const State<Board> *state, int price, int tile, int from, int to) const {
+	return (price + manhattanDistanceDiff(state, tile, from, to));
+}
+
+template <typename Board>
+int	Heuristic::MDplusLinearConflictsDelta(const State<Board> *state, int price, int tile, int from, int to) const {
+	return (price + manhattanDistanceDiff(state, tile, from, to) +
+			linearConflictsDiff(state, tile, from, to));
+}
+
+template <typename Board>
+int	Heuristic::MTplusLinearConflictsDelta(const State<Board> *state, int price, int tile, int from, int to) const {
+	return (price + misplacedTilesDiff(state, tile, from, to) +
+			linearConflictsDiff(state, tile, from, to));
+}
+
+// a move merges or splits cycles, so only cycles through 'from' and 'to' are recounted
+template <typename Board>
+int	Heuristic::nMaxSwapDelta(const State<Board> *state, int price, int tile, int from, int to) const {
+	const Board	&map = state->board;
+	const int	*goal = goalIndex.data();
+	auto		childTileAt = [&map](int i) { return (map.get(i)); };
+	auto		parentTileAt = [&map, tile, from, to](int i) {
+		if (i == from)
+			return (tile);
+		return (i == to ? 0 : map.get(i));
+	};
+
+	return (price + cyclesCost(childTileAt, goal, to, from) -
+			cyclesCost(parentTileAt, goal, to, from));
+}
+
+// only the pattern of the moved tile changes
+template <typename Board>
+int	Heuristic::patternDatabaseDelta(const State<Board> *state, int price, int tile, int from, int to) const {
+	const Board				&map = state->board;
+	const int				renamed = rename.empty() ? tile : rename[tile];
+	const PatternDatabase	&pattern = *patterns[tilePattern[renamed]];
+	int						tilePlaces[mapLength];
+	int						diff;
+
+	if (rename.empty()) {
+		for (int i = 0; i < mapLength; i++)
+			tilePlaces[map.get(i)] = i;
+	}
+	else {
+		for (int i = 0; i < mapLength; i++)
+			tilePlaces[rename[map.get(i)]] = i;
+	}
+	diff = pattern.value(tilePlaces);
+	tilePlaces[renamed] = from;
+	return (price + diff - pattern.value(tilePlaces));
+}
+
+template int	Heuristic::misplacedTiles(const State<NP_Board16> *state) const;
+template int	Heuristic::misplacedTiles(const State<NP_Board64> *state) const;
+template int	Heuristic::manhattanDistance(const State<NP_Board16> *state) const;
+template int	Heuristic::manhattanDistance(const State<NP_Board64> *state) const;
+template int	Heuristic::MDplusLinearConflicts(const State<NP_Board16> *state) const;
+template int	Heuristic::MDplusLinearConflicts(const State<NP_Board64> *state) const;
+template int	Heuristic::MTplusLinearConflicts(const State<NP_Board16> *state) const;
+template int	Heuristic::MTplusLinearConflicts(const State<NP_Board64> *state) const;
+template int	Heuristic::nMaxSwap(const State<NP_Board16> *state) const;
+template int	Heuristic::nMaxSwap(const State<NP_Board64> *state) const;
+template int	Heuristic::patternDatabase(const State<NP_Board16> *state) const;
+template int	Heuristic::patternDatabase(const State<NP_Board64> *state) const;
+
+template int	Heuristic::misplacedTilesDelta(const State<NP_Board16> *state, int price, int tile, int from, int to) const;
+template int	Heuristic::misplacedTilesDelta(const State<NP_Board64> *state, int price, int tile, int from, int to) const;
+template int	Heuristic::manhattanDistanceDelta(const State<NP_Board16> *state, int price, int tile, int from, int to) const;
+template int	Heuristic::manhattanDistanceDelta(const State<NP_Board64> *state, int price, int tile, int from, int to) const;
+template int	Heuristic::MDplusLinearConflictsDelta(const State<NP_Board16> *state, int price, int tile, int from, int to) const;
+template int	Heuristic::MDplusLinearConflictsDelta(const State<NP_Board64> *state, int price, int tile, int from, int to) const;
+template int	Heuristic::MTplusLinearConflictsDelta(const State<NP_Board16> *state, int price, int tile, int from, int to) const;
+template int	Heuristic::MTplusLinearConflictsDelta(const State<NP_Board64> *state, int price, int tile, int from, int to) const;
+template int	Heuristic::nMaxSwapDelta(const State<NP_Board16> *state, int price, int tile, int from, int to) const;
+template int	Heuristic::nMaxSwapDelta(const State<NP_Board64> *state, int price, int tile, int from, int to) const;
+template int	Heuristic::patternDatabaseDelta(const State<NP_Board16> *state, int price, int tile, int from, int to) const;
+template int	Heuristic::patternDatabaseDelta(const State<NP_Board64> *state, int price, int tile, int from, int to) const;
@@ -1,16 +1,72 @@
 #ifndef N_PUZZLE_HEURISTICFUNCTIONS_HPP
 #define N_PUZZLE_HEURISTICFUNCTIONS_HPP
 
-class State;
+#include <memory>
+#include <vector>
 
+template <typename Board> class State;
+class PatternDatabase;
+
+/*
+ * Tables of one solve, heuristic functions are members,
+ * so every solve reads only its own tables.
+ */
 class Heuristic {
-	static int	linearConflicts(const State *state);
+	// indexed by tile value
+	std::vector<int>	goalIndex;
+	std::vector<int>	goalRow;
+	std::vector<int>	goalCol;
+	std::vector<int>	distances;	// [tile * mapLength + place] -> manhattan distance
+	int					mapSize, mapLength;
+	std::vector<std::shared_ptr<const PatternDatabase>>	patterns;
+	std::vector<int>	tilePattern;	// [tile] -> index in patterns
+	std::vector<int>	rename;			// [tile] -> tile of the pattern databases, empty if the same
+
+	template <typename Board>
+	int	linearConflicts(const State<Board> *state) const;
+	template <typename Board>
+	int	misplacedTilesDiff(const State<Board> *state, int tile, int from, int to) const;
+	template <typename Board>
+	int	manhattanDistanceDiff(const State<Board> *state, int tile, int from, int to) const;
+	template <typename Board>
+	int	linearConflictsDiff(const State<Board> *state, int tile, int from, int to) const;
 public:
-	static int	misplacedTiles(const State *state);
-	static int	manhattanDistance(const State *state);
-	static int	MDplusLinearConflicts(const State *state);
-	static int	MTplusLinearConflicts(const State *state);
-	static int	nMaxSwap(const State *state);
+	Heuristic() : mapSize(0), mapLength(0) {};
+
+	void	initTables(const int *finishMap, int mapSize);
+	// maps tables from PatternDatabase::directory, throws if they weren't generated
+	void	initPatterns(const int *finishMap, int mapSize, int solutionType);
+	// tables of a search heading to 'goalMap', like the backward one of bidirectional search;
+	// pattern databases of 'forward' are shared, tiles are renamed so 'goalMap' becomes 'finishMap',
+	// which works only with the empty piece on the same place, false if they aren't shared
+	bool	initReversed(const Heuristic &forward, const int *finishMap, const int *goalMap);
+
+	template <typename Board>
+	int	misplacedTiles(const State<Board> *state) const;
+	template <typename Board>
+	int	manhattanDistance(const State<Board> *state) const;
+	template <typename Board>
+	int	MDplusLinearConflicts(const State<Board> *state) const;
+	template <typename Board>
+	int	MTplusLinearConflicts(const State<Board> *state) const;
+	template <typename Board>
+	int	nMaxSwap(const State<Board> *state) const;
+	template <typename Board>
+	int	patternDatabase(const State<Board> *state) const;
+
+	// price of the state after 'tile' was moved 'from' -> 'to', 'price' is the parent's price
+	template <typename Board>
+	int	misplacedTilesDelta(const State<Board> *state, int price, int tile, int from, int to) const;
+	template <typename Board>
+	int	manhattanDistanceDelta(const State<Board> *state, int price, int tile, int from, int to) const;
+	template <typename Board>
+	int	MDplusLinearConflictsDelta(const State<Board> *state, int price, int tile, int from, int to) const;
+	template <typename Board>
+	int	MTplusLinearConflictsDelta(const State<Board> *state, int price, int tile, int from, int to) const;
+	template <typename Board>
+	int	nMaxSwapDelta(const State<Board> *state, int price, int tile, int from, int to) const;
+	template <typename Board>
+	int	patternDatabaseDelta(const State<Board> *state, int price, int tile, int from, int to) const;
 };
 
 #endif //N_PUZZLE_HEURISTICFUNCTIONS_HPP
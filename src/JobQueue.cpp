@@ -0,0 +1,182 @@
+#include "JobQueue.hpp"
+#include "State.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+#include <vector>
+
+JobQueue::JobQueue(size_t workers)
+	: heavySlots(std::max<size_t>(workers / 2, 1)), lastId(0), runningHeavy(0), closed(false) {
+}
+
+int		JobQueue::difficulty(const int *map, int mapLength, int solutionType) {
+	int		mapSize = 0;
+	int		distance = 0;
+
+	while (mapSize * mapSize < mapLength)
+		mapSize++;
+	if (mapLength <= 0 || mapSize * mapSize != mapLength)
+		return (0);
+
+	std::vector<int>	finishMap(mapLength);
+	std::vector<int>	finishPlace(mapLength, -1);
+
+	State<NP_Board64>::makeFinishMap(solutionType, mapSize, finishMap.data());
+	for (int i = 0; i < mapLength; i++)
+		finishPlace[finishMap[i]] = i;
+	for (int i = 0; i < mapLength; i++) {
+		if (map[i] < 0 || map[i] >= mapLength)
+			return (0);
+		if (map[i] != 0)
+			distance += std::abs(i % mapSize - finishPlace[map[i]] % mapSize) +
+						std::abs(i / mapSize - finishPlace[map[i]] / mapSize);
+	}
+	return (mapLength * distance);
+}
+
+// mutex is locked
+JobQueue::Entry	&JobQueue::find(size_t id) {
+	auto	it = jobs.find(id);
+
+	if (it == jobs.end())
+		throw NP_UnknownJob();
+	return (it->second);
+}
+
+// mutex is locked
+void	JobQueue::finish(Entry &entry, int status) {
+	entry.info.status = status;
+	entry.info.hasProgress = false;
+	finished.push_back(entry.job->id);
+	// answers which nobody fetched
+	while (finished.size() > NP_MAX_FINISHED_JOBS) {
+		jobs.erase(finished.front());
+		finished.pop_front();
+	}
+}
+
+size_t	JobQueue::submit(const NP_message &task, int priority, int difficulty) {
+	std::lock_guard<std::mutex>	lock(mutex);
+	Entry						entry;
+
+	if (closed || light.size() + heavy.size() >= NP_MAX_QUEUED_JOBS ||
+		(difficulty >= NP_HEAVY_JOB && heavy.size() >= NP_MAX_QUEUED_HEAVY))
+		throw NP_QueueIsFull();
+	entry.job = std::make_shared<Job>(++lastId, priority, difficulty, task);
+	entry.info.status = QUEUED;
+	entry.info.position = 0;
+	entry.info.hasProgress = false;
+	(entry.job->isHeavy() ? heavy : light).insert(entry.job);
+	jobs.emplace(lastId, entry);
+	return (lastId);
+}
+
+std::shared_ptr<JobQueue::Job>	JobQueue::next() {
+	std::lock_guard<std::mutex>	lock(mutex);
+	Queue						*queue = &light;
+
+	if (closed)
+		return (nullptr);
+	if (!heavy.empty() && runningHeavy < heavySlots)
+		queue = &heavy;
+	if (queue->empty())
+		return (nullptr);
+
+	std::shared_ptr<Job>	job = *queue->begin();
+
+	queue->erase(queue->begin());
+	if (job->isHeavy())
+		runningHeavy++;
+	jobs[job->id].info.status = RUNNING;
+	return (job);
+}
+
+void	JobQueue::progress(size_t id, const NP_progress &progress) {
+	std::lock_guard<std::mutex>	lock(mutex);
+	auto						it = jobs.find(id);
+
+	if (it != jobs.end() && it->second.info.status == RUNNING) {
+		it->second.info.progress = progress;
+		it->second.info.hasProgress = true;
+	}
+}
+
+void	JobQueue::done(const std::shared_ptr<Job> &job, const std::string &answer) {
+	std::lock_guard<std::mutex>	lock(mutex);
+	auto						it = jobs.find(job->id);
+
+	if (job->isHeavy())
+		runningHeavy--;
+	// the answer of a cancelled job is the error of its budget
+	if (it != jobs.end() && it->second.info.status == RUNNING) {
+		it->second.info.answer = answer;
+		finish(it->second, job->cancel->load() ? CANCELLED : DONE);
+	}
+}
+
+JobQueue::Info	JobQueue::status(size_t id) const {
+	std::lock_guard<std::mutex>	lock(mutex);
+	auto						it = jobs.find(id);
+
+	if (it == jobs.end())
+		throw NP_UnknownJob();
+
+	Info	info = it->second.info;
+
+	if (info.status == QUEUED) {
+		const std::shared_ptr<Job>	&job = it->second.job;
+		const Queue					&queue = job->isHeavy() ? heavy : light;
+
+		info.position = std::distance(queue.begin(), queue.find(job));
+	}
+	info.answer.clear();
+	return (info);
+}
+
+JobQueue::Info	JobQueue::fetch(size_t id) {
+	std::lock_guard<std::mutex>	lock(mutex);
+	Entry						&entry = find(id);
+	Info						info = entry.info;
+
+	if (info.status == DONE || info.status == CANCELLED) {
+		finished.erase(std::find(finished.begin(), finished.end(), id));
+		jobs.erase(id);
+	}
+	else
+		info.answer.clear();
+	return (info);
+}
+
+JobQueue::Info	JobQueue::cancel(size_t id) {
+	std::lock_guard<std::mutex>	lock(mutex);
+	Entry						&entry = find(id);
+
+	// finished job stays as it is
+	if (entry.info.status == QUEUED || entry.info.status == RUNNING)
+		entry.job->cancel->store(true);
+	// running job is finished by its worker, which gets the cancelled budget
+	if (entry.info.status == QUEUED) {
+		(entry.job->isHeavy() ? heavy : light).erase(entry.job);
+		finish(entry, CANCELLED);
+	}
+
+	Info	info = entry.info;
+
+	info.answer.clear();
+	return (info);
+}
+
+void	JobQueue::close() {
+	std::lock_guard<std::mutex>	lock(mutex);
+
+	closed = true;
+	for (auto &job : jobs)
+		job.second.job->cancel->store(true);
+}
+
+const char	*JobQueue::statusName(int status) {
+	static const char	*names[] = {"queued", "running", "done", "cancelled"};
+
+	return (names[status]);
+}
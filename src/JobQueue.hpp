@@ -0,0 +1,126 @@
+#ifndef JOB_QUEUE_HPP
+#define JOB_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include "Budget.hpp"
+#include "JsonCodec.hpp"
+
+#define NP_MAX_QUEUED_JOBS		1024	// jobs waiting for a worker
+#define NP_MAX_QUEUED_HEAVY		64		// heavy ones among them
+#define NP_MAX_FINISHED_JOBS	1024	// answers which aren't fetched, the oldest ones are dropped
+#define NP_HEAVY_JOB			1000	// difficulty of a heavy job, most of 5x5 puzzles and larger
+
+/*
+ * Tasks which are solved in background, clients poll them by id.
+ * A free worker takes the job of the highest priority, then of the smallest difficulty,
+ * then the oldest one. Heavy jobs run on at most half of the workers, so easy ones
+ * always have a worker; while that half isn't full, heavy jobs go first, so they
+ * aren't starved either. Difficulty is the amount of places times the manhattan distance
+ * of the map, it's cheap and orders puzzles by size first.
+ * Queue is bounded, a job which doesn't fit is rejected.
+ */
+class JobQueue
+{
+public:
+	enum jobStatus { QUEUED, RUNNING, DONE, CANCELLED };
+
+	struct Job {
+		const size_t						id;
+		const int							priority;
+		const int							difficulty;
+		const NP_message					task;		// message of the task
+		std::shared_ptr<std::atomic<bool>>	cancel;
+
+		Job(size_t id, int priority, int difficulty, const NP_message &task)
+			: id(id), priority(priority), difficulty(difficulty), task(task),
+			cancel(new std::atomic<bool>(false)) {};
+		bool	isHeavy() const { return (difficulty >= NP_HEAVY_JOB); }
+	};
+
+	// state of a job for its client
+	struct Info {
+		int			status;		// jobStatus
+		size_t		position;	// jobs which go before a queued one
+		bool		hasProgress;
+		NP_progress	progress;	// of a running job
+		std::string	answer;		// answer of the task of a done job
+	};
+
+private:
+	struct Entry {
+		std::shared_ptr<Job>	job;
+		Info					info;
+	};
+
+	struct Order {
+		bool	operator()(const std::shared_ptr<Job> &lhs, const std::shared_ptr<Job> &rhs) const {
+			if (lhs->priority != rhs->priority)
+				return (lhs->priority > rhs->priority);
+			if (lhs->difficulty != rhs->difficulty)
+				return (lhs->difficulty < rhs->difficulty);
+			return (lhs->id < rhs->id);
+		}
+	};
+
+	typedef std::set<std::shared_ptr<Job>, Order>	Queue;
+
+	const size_t							heavySlots;	// workers for heavy jobs
+	size_t									lastId;
+	size_t									runningHeavy;
+	bool									closed;
+	Queue									light;
+	Queue									heavy;
+	std::unordered_map<size_t, Entry>		jobs;
+	std::deque<size_t>						finished;	// ids of done and cancelled jobs, the oldest first
+	mutable std::mutex						mutex;
+
+	//disable copy constructor;
+	JobQueue(const JobQueue &rhs);
+	JobQueue	&operator=(const JobQueue &rhs);
+
+	Entry	&find(size_t id);
+	void	finish(Entry &entry, int status);
+
+public:
+	// 'workers' is the amount of threads which run jobs
+	explicit JobQueue(size_t workers);
+	~JobQueue() {};
+
+	// difficulty of the task, 0 if the map is broken, its solve fails fast
+	static int	difficulty(const int *map, int mapLength, int solutionType);
+
+	size_t					submit(const NP_message &task, int priority, int difficulty);
+	// the next job for a free worker, nullptr if no job can run now
+	std::shared_ptr<Job>	next();
+	void					progress(size_t id, const NP_progress &progress);
+	void					done(const std::shared_ptr<Job> &job, const std::string &answer);
+
+	Info	status(size_t id) const;
+	// answer of a finished job, the job is forgotten then
+	Info	fetch(size_t id);
+	Info	cancel(size_t id);
+	// no more jobs are started, running ones are cancelled
+	void	close();
+
+	static const char	*statusName(int status);
+
+	class	NP_QueueIsFull : public std::exception {
+	public:
+		virtual const char	*what() const throw() {return ("Queue of jobs is full, try later");};
+	};
+
+	class	NP_UnknownJob : public std::exception {
+	public:
+		virtual const char	*what() const throw() {return ("Unknown job");};
+	};
+};
+
+#endif // JOB_QUEUE_HPP
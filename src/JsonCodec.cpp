@@ -0,0 +1,384 @@
+#include "JsonCodec.hpp"
+
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#define NP_JSON_MAX_DEPTH	64	// of skipped values, deeper ones are rejected
+
+static const char	*fieldNames[] = {
+	"messageType", "map", "heuristicFunction", "solutionType", "algorithm", "optimisation", "weight",
+	"threads", "profile", "maxTime", "maxNodes", "maxMemory", "priority", "id"
+};
+
+NP_message::NP_message()
+	: messageType(-1), heuristic(0), solutionType(0), algorithm(0), optimisation(0), weight(0), threads(0),
+	profile(false), maxTime(0), maxNodes(0), maxMemory(0), priority(0), id(0), fields(0) {
+}
+
+void	NP_message::require(int field) const {
+	if (!has(field))
+		throw NP_MissingField(field);
+}
+
+NP_message::NP_MissingField::NP_MissingField(int field)
+	: message(std::string("Missing field ") + fieldNames[field]) {
+}
+
+JsonCodec::NP_ParseError::NP_ParseError(const char *reason, size_t offset)
+	: message(std::string(reason) + " at " + std::to_string(offset)) {
+}
+
+/*
+ * Cursor over the text of a message. Keys and values are compared and converted
+ * where they are, only the map is copied out.
+ */
+class JsonReader {
+	const char	*begin;
+	const char	*p;
+	const char	*end;
+
+public:
+	explicit JsonReader(const std::string &json)
+		: begin(json.data()), p(json.data()), end(json.data() + json.size()) {};
+
+	void	fail(const char *reason) const { throw JsonCodec::NP_ParseError(reason, p - begin); }
+
+	void	skipSpaces() {
+		while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+			p++;
+	}
+
+	bool	peek(char c) {
+		skipSpaces();
+		return (p < end && *p == c);
+	}
+
+	void	expect(char c) {
+		if (!peek(c))
+			fail("Unexpected character");
+		p++;
+	}
+
+	bool	accept(char c) {
+		if (!peek(c))
+			return (false);
+		p++;
+		return (true);
+	}
+
+	bool	atEnd() {
+		skipSpaces();
+		return (p == end);
+	}
+
+	// contents of the string without its quotes, escapes are left as they are
+	void	string(const char *&from, size_t &length) {
+		expect('"');
+		from = p;
+		while (p < end && *p != '"') {
+			if (*p == '\\' && ++p == end)
+				break ;
+			p++;
+		}
+		if (p == end)
+			fail("Unterminated string");
+		length = p++ - from;
+	}
+
+	void	skipValue(int depth = 0) {
+		const char	*from;
+		size_t		length;
+
+		if (depth > NP_JSON_MAX_DEPTH)
+			fail("Too deep value");
+		skipSpaces();
+		if (p == end)
+			fail("Missing value");
+		if (*p == '"')
+			string(from, length);
+		else if (*p == '{' || *p == '[') {
+			const char	close = (*p++ == '{') ? '}' : ']';
+
+			if (accept(close))
+				return ;
+			do {
+				if (close == '}') {
+					string(from, length);
+					expect(':');
+				}
+				skipValue(depth + 1);
+			} while (accept(','));
+			expect(close);
+		}
+		else {
+			// numbers, true, false and null
+			from = p;
+			while (p < end && (std::isalnum((unsigned char)*p) || *p == '-' || *p == '+' || *p == '.'))
+				p++;
+			if (p == from)
+				fail("Invalid value");
+		}
+	}
+
+	// number, or string with a number, like values of property_tree, it's copied to 'buffer'
+	void	token(char *buffer, size_t size, bool real) {
+		const bool	quoted = accept('"');
+		const char	*from = p;
+
+		while (p < end && (std::isdigit((unsigned char)*p) || *p == '-' || *p == '+' ||
+							(real && (*p == '.' || *p == 'e' || *p == 'E'))))
+			p++;
+		if (p == from || (size_t)(p - from) >= size)
+			fail("Invalid number");
+		std::memcpy(buffer, from, p - from);
+		buffer[p - from] = '\0';
+		if (quoted)
+			expect('"');
+	}
+
+	int		integer() {
+		char		buffer[32];
+		char		*last;
+		long long	value;
+
+		token(buffer, sizeof(buffer), false);
+		errno = 0;
+		value = std::strtoll(buffer, &last, 10);
+		if (*last != '\0' || errno == ERANGE ||
+			value < std::numeric_limits<int>::min() || value > std::numeric_limits<int>::max())
+			fail("Invalid number");
+		return ((int)value);
+	}
+
+	size_t	size() {
+		char				buffer[32];
+		char				*last;
+		unsigned long long	value;
+
+		token(buffer, sizeof(buffer), false);
+		errno = 0;
+		value = std::strtoull(buffer, &last, 10);
+		if (buffer[0] == '-' || *last != '\0' || errno == ERANGE)
+			fail("Invalid number");
+		return ((size_t)value);
+	}
+
+	double	real() {
+		char	buffer[64];
+		char	*last;
+		double	value;
+
+		token(buffer, sizeof(buffer), true);
+		errno = 0;
+		value = std::strtod(buffer, &last);
+		if (*last != '\0' || errno == ERANGE)
+			fail("Invalid number");
+		return (value);
+	}
+
+	bool	boolean() {
+		const bool	quoted = peek('"');
+		const char	*word = p + quoted;
+		bool		value;
+
+		if (end - word >= 4 && !std::strncmp(word, "true", 4))
+			value = true;
+		else if (end - word >= 5 && !std::strncmp(word, "false", 5))
+			value = false;
+		else
+			return (integer() != 0);
+		p = word + (value ? 4 : 5);
+		if (quoted)
+			expect('"');
+		return (value);
+	}
+};
+
+// index of the key in 'fieldNames', -1 if it's unknown
+static int	fieldOf(const char *key, size_t length) {
+	for (size_t i = 0; i < sizeof(fieldNames) / sizeof(fieldNames[0]); i++)
+		if (std::strlen(fieldNames[i]) == length && !std::memcmp(fieldNames[i], key, length))
+			return (i);
+	return (-1);
+}
+
+static void	parseField(JsonReader &reader, int field, NP_message &message) {
+	switch (field) {
+		case MAP:
+			message.map.clear();
+			reader.expect('[');
+			if (!reader.accept(']')) {
+				do
+					message.map.push_back(reader.integer());
+				while (reader.accept(','));
+				reader.expect(']');
+			}
+			break;
+		case HEURISTIC:		message.heuristic = reader.integer(); break;
+		case SOLUTION_TYPE:	message.solutionType = reader.integer(); break;
+		case ALGORITHM:		message.algorithm = reader.integer(); break;
+		case OPTIMISATION:	message.optimisation = reader.integer(); break;
+		case WEIGHT:		message.weight = reader.real(); break;
+		case THREADS:		message.threads = reader.integer(); break;
+		case PROFILE:		message.profile = reader.boolean(); break;
+		case MAX_TIME:		message.maxTime = reader.real(); break;
+		case MAX_NODES:		message.maxNodes = reader.size(); break;
+		case MAX_MEMORY:	message.maxMemory = reader.size(); break;
+		case PRIORITY:		message.priority = reader.integer(); break;
+		case JOB_ID:		message.id = reader.size(); break;
+	}
+	message.fields |= 1u << field;
+}
+
+// members of an object, 'data' is the object with the fields of the message
+static void	parseObject(JsonReader &reader, NP_message &message, bool data) {
+	const char	*key;
+	size_t		length;
+
+	reader.expect('{');
+	if (reader.accept('}'))
+		return ;
+	do {
+		reader.string(key, length);
+		reader.expect(':');
+
+		const int	field = fieldOf(key, length);
+
+		if (!data && length == 4 && !std::memcmp(key, "data", 4))
+			parseObject(reader, message, true);
+		else if (!data && field == MESSAGE_TYPE) {
+			message.messageType = reader.integer();
+			message.fields |= 1u << MESSAGE_TYPE;
+		}
+		else if (data && field > MESSAGE_TYPE)
+			parseField(reader, field, message);
+		else
+			reader.skipValue();
+	} while (reader.accept(','));
+	reader.expect('}');
+}
+
+void	JsonCodec::parse(const std::string &json, NP_message &message) {
+	JsonReader	reader(json);
+
+	parseObject(reader, message, false);
+	if (!reader.atEnd())
+		reader.fail("Unexpected character");
+}
+
+JsonWriter::JsonWriter(std::string &out) : out(out) {
+}
+
+void	JsonWriter::key(const char *key) {
+	if (!first.empty()) {
+		if (!first.back())
+			out += ',';
+		first.back() = false;
+	}
+	if (key) {
+		string(key);
+		out += ':';
+	}
+}
+
+// escapes of property_tree, '/' and control characters too
+void	JsonWriter::string(const std::string &value) {
+	static const char	hex[] = "0123456789ABCDEF";
+
+	out += '"';
+	for (unsigned char c : value) {
+		if (c >= 0x20 && c != '"' && c != '\\' && c != '/')
+			out += c;
+		else if (c == '\b')
+			out += "\\b";
+		else if (c == '\f')
+			out += "\\f";
+		else if (c == '\n')
+			out += "\\n";
+		else if (c == '\r')
+			out += "\\r";
+		else if (c == '\t')
+			out += "\\t";
+		else if (c == '"' || c == '\\' || c == '/') {
+			out += '\\';
+			out += c;
+		}
+		else {
+			out += "\\u00";
+			out += hex[c >> 4];
+			out += hex[c & 0xF];
+		}
+	}
+	out += '"';
+}
+
+void	JsonWriter::number(const char *value) {
+	out += '"';
+	out += value;
+	out += '"';
+}
+
+void	JsonWriter::beginObject(const char *key) {
+	this->key(key);
+	out += '{';
+	first.push_back(true);
+}
+
+void	JsonWriter::endObject() {
+	out += '}';
+	first.pop_back();
+}
+
+void	JsonWriter::beginArray(const char *key) {
+	this->key(key);
+	out += '[';
+	first.push_back(true);
+}
+
+void	JsonWriter::endArray() {
+	out += ']';
+	first.pop_back();
+}
+
+void	JsonWriter::put(const char *key, const std::string &value) {
+	this->key(key);
+	string(value);
+}
+
+void	JsonWriter::put(const char *key, int value) {
+	char	buffer[16];
+
+	this->key(key);
+	std::snprintf(buffer, sizeof(buffer), "%d", value);
+	number(buffer);
+}
+
+void	JsonWriter::put(const char *key, size_t value) {
+	char	buffer[24];
+
+	this->key(key);
+	std::snprintf(buffer, sizeof(buffer), "%zu", value);
+	number(buffer);
+}
+
+// the precision of property_tree, so values are the same
+void	JsonWriter::put(const char *key, double value) {
+	char	buffer[32];
+
+	this->key(key);
+	std::snprintf(buffer, sizeof(buffer), "%.*g", std::numeric_limits<double>::max_digits10, value);
+	number(buffer);
+}
+
+void	JsonWriter::put(const char *key, bool value) {
+	this->key(key);
+	number(value ? "true" : "false");
+}
+
+void	JsonWriter::finish() {
+	out += '\n';
+}
@@ -0,0 +1,96 @@
+#ifndef JSON_CODEC_HPP
+#define JSON_CODEC_HPP
+
+#include <cstddef>
+#include <exception>
+#include <string>
+#include <vector>
+
+enum messageFields {
+	MESSAGE_TYPE, MAP, HEURISTIC, SOLUTION_TYPE, ALGORITHM, OPTIMISATION, WEIGHT, THREADS,
+	PROFILE, MAX_TIME, MAX_NODES, MAX_MEMORY, PRIORITY, JOB_ID
+};
+
+/*
+ * Message of a client, see jsonExamples.json. Fields which aren't in the message
+ * keep their defaults, 'fields' tells which ones were there.
+ */
+class NP_message {
+public:
+	int					messageType;	// -1 if it's missing, no message has this type
+	std::vector<int>	map;
+	int					heuristic;
+	int					solutionType;
+	int					algorithm;
+	int					optimisation;
+	double				weight;
+	int					threads;
+	bool				profile;
+	double				maxTime;
+	size_t				maxNodes;
+	size_t				maxMemory;
+	int					priority;
+	size_t				id;			// of a job
+	unsigned			fields;		// bits of messageFields
+
+	NP_message();
+	bool	has(int field) const { return (this->fields & (1u << field)); }
+	// throws NP_MissingField if the message hasn't the field
+	void	require(int field) const;
+
+	class	NP_MissingField : public std::exception {
+		std::string	message;
+
+	public:
+		explicit NP_MissingField(int field);
+		virtual const char	*what() const throw() { return (message.c_str()); };
+	};
+};
+
+/*
+ * JSON of the server without a tree of nodes: messages are read in place from the text
+ * of the request, unknown fields are skipped, and answers are written straight into
+ * their string. Values are written as strings, like boost::property_tree does,
+ * so the answers stay the same for clients. Numbers are read from numbers and strings.
+ */
+class JsonCodec {
+public:
+	static void	parse(const std::string &json, NP_message &message);
+
+	class	NP_ParseError : public std::exception {
+		std::string	message;
+
+	public:
+		NP_ParseError(const char *reason, size_t offset);
+		virtual const char	*what() const throw() { return (message.c_str()); };
+	};
+};
+
+// writer of one JSON document, every 'begin' needs its 'end'
+class JsonWriter {
+	std::string			&out;
+	std::vector<bool>	first;	// [depth] -> no value is written at the depth yet
+
+	void	key(const char *key);
+	void	string(const std::string &value);
+	void	number(const char *value);
+
+public:
+	explicit JsonWriter(std::string &out);
+
+	void	beginObject(const char *key = nullptr);
+	void	endObject();
+	void	beginArray(const char *key = nullptr);
+	void	endArray();
+	// 'key' is nullptr for elements of arrays
+	void	put(const char *key, const std::string &value);
+	void	put(const char *key, const char *value) { put(key, std::string(value)); }
+	void	put(const char *key, int value);
+	void	put(const char *key, size_t value);
+	void	put(const char *key, double value);
+	void	put(const char *key, bool value);
+	// the end of the document
+	void	finish();
+};
+
+#endif // JSON_CODEC_HPP
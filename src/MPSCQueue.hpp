@@ -0,0 +1,58 @@
+#ifndef MPSC_QUEUE_HPP
+#define MPSC_QUEUE_HPP
+
+#include <atomic>
+#include <utility>
+
+/*
+ * Lock-free queue with many producers and one consumer.
+ * Producers push with compare-and-swap on the head, the consumer takes
+ * everything at once with a single exchange, so there is no ABA problem.
+ * Items come out in reverse order of pushing.
+ */
+template <typename T>
+class MPSCQueue
+{
+public:
+	struct Node {
+		T		value;
+		Node	*next;
+
+		explicit Node(T &&value) : value(std::move(value)), next(nullptr) {};
+	};
+
+private:
+	std::atomic<Node *>	head;
+
+	//disable copy constructor;
+	MPSCQueue(const MPSCQueue &rhs);
+	MPSCQueue	&operator=(const MPSCQueue &rhs);
+
+public:
+	MPSCQueue() : head(nullptr) {};
+	~MPSCQueue() {
+		Node	*node = popAll();
+
+		while (node != nullptr) {
+			Node	*next = node->next;
+
+			delete node;
+			node = next;
+		}
+	}
+
+	void	push(T &&value) {
+		Node	*node = new Node(std::move(value));
+
+		node->next = head.load(std::memory_order_relaxed);
+		while (!head.compare_exchange_weak(node->next, node,
+					std::memory_order_release, std::memory_order_relaxed))
+			;
+	}
+
+	// list of every pushed node, caller deletes them
+	Node	*popAll() { return (head.exchange(nullptr, std::memory_order_acquire)); }
+	bool	empty() const { return (head.load(std::memory_order_relaxed) == nullptr); }
+};
+
+#endif // MPSC_QUEUE_HPP
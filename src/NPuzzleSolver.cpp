@@ -1,97 +1,424 @@
 #include "main.hpp"
 
-#include <unordered_set>
+#include <algorithm>
 #include <cassert>
+#include <limits>
 #include <cmath>
 #include <memory>
 #include <iostream>
+#include <chrono>
+#include <thread>
 #include "NPuzzleSolver.hpp"
 #include "Heuristic.hpp"
+#include "SolverContext.hpp"
+#include "ParallelAStar.hpp"
+#include "BidirectionalAStar.hpp"
 
-void NPuzzleSolver::checkPath(const State &root, const NP_retVal &result) const {
+template <typename Board>
+bool NPuzzleSolver::checkPath(const SolverContext<Board> &ctx, const State<Board> &root,
+								const NP_retVal &result) const {
 	std::string ss[] = {"ROOT", "UP", "DOWN", "LEFT", "RIGHT"};
-	State *state = nullptr;
-	State *prev = nullptr;
+	const State<Board> *prev = &root;
+	State<Board> *state = nullptr;
+	bool valid = true;
 
 	std::cout << "###### PRINT PATH ######" << std::endl << "ROOT" << std::endl;
-	root.printState();
+	root.printState(ctx);
 	for (auto const &move: result.path) {
+		if (!prev->canMove(ctx, move)) {
+			std::cout << "Error: invalid move " << move << std::endl;
+			valid = false;
+			break;
+		}
 		std::cout << "Move: " << ss[move] << std::endl << std::flush;
-		if (move == 0)
-			state = new State(root, move);
-		else // if can't create State with this move, then constructor throw exception
-			state = new State(*prev, move);
+		state = new State<Board>(ctx, *prev, move);
 
-		if (prev != nullptr)
+		if (prev != &root)
 			 delete prev;
 		prev = state;
-		state->printState();
+		state->printState(ctx);
 	}
-	if (state != nullptr)
-		 delete state;
+	if (prev != &root)
+		 delete prev;
+	return (valid);
 }
 
-static void createRetVal(NPqueue &open, NPset &closed, const std::shared_ptr<State> &curr, unsigned int maxOpen, NP_retVal &result) {
-	size_t	summ = open.size() + closed.size();
-	size_t i = 0;
-	const State *ptr = curr.get();
-
-	result.maxOpen = maxOpen;
-	result.usedMemory = summ * (sizeof(State) + sizeof(int) * 1 /* curr->mapLength */ );
-	result.closedNodes = closed.size();
+template <typename Board>
+static void createRetVal(const NParena<Board> &arena, uint32_t curr, NP_retVal &result) {
+	const State<Board> *ptr = &arena[curr];
 
 	while (ptr->getMove() != ROOT) {
-	    i++;
 		result.path.push_front(ptr->getMove());
-        ptr = ptr->getPrev();
+		ptr = &arena[ptr->getPrev()];
 	}
 	result.path.push_front(ROOT);
 }
 
-void NPuzzleSolver::aStar(const int *map, NP_retVal &result) {
-    NPqueue	open;
-    NPset	closed;
+// counters of a best-first search
+struct SearchCounters {
+	size_t	expanded;
+	size_t	generated;
+	size_t	duplicates;
+	size_t	maxOpen;
+
+	SearchCounters() : expanded(0), generated(0), duplicates(0), maxOpen(1) {};
+};
+
+// 'usedMemory' is the memory of every structure of the search
+static void saveStats(Profiler &profiler, std::chrono::steady_clock::time_point searchStart,
+						const SearchCounters &counters, size_t usedMemory, NP_retVal &result) {
+	profiler.stop(EXPANSION_PHASE, searchStart, counters.expanded);
+	profiler.save(result.profile);
+	result.maxOpen = counters.maxOpen;
+	result.closedNodes = counters.expanded;
+	result.generatedNodes = counters.generated;
+	result.duplicates = counters.duplicates;
+	result.usedMemory = usedMemory;
+}
 
-    auto addNewState = [&open, &closed](const std::shared_ptr<State> &curr, int move) {
-        try {
-            auto newState = std::make_shared<State>(*(curr.get()), move);
-            open.push(std::move(newState));
-        }
-        catch (State::NP_InvalidMove &e) {
-            // can't create State with this move, let's try next move
-            // std::cout << "can't create State with this move, let's try next move" << std::endl;
-        }
+/*
+ * Children of 'curr' which are new boards or shorter paths to known ones go to 'push',
+ * the others are dropped. Expanded boards come back only if 'reopen', then push gets
+ * them with 'closed' set and their slots stay closed.
+ */
+template <typename Board, typename Push>
+static void expandNode(const SolverContext<Board> &ctx, NParena<Board> &arena, NodeTable<Board> &table,
+						Profiler &profiler, uint32_t curr, bool reopen, SearchCounters &counters, Push push) {
+	// arena never moves nodes, so reference stays valid while children are created
+	const State<Board>	&state = arena[curr];
+	int					moves[LAST];
+	bool				inserted;
+	bool				closed;
+
+	// only legal moves, so constructor of State never throws here
+	const int	movesCount = state.getMoves(ctx, moves);
+
+	counters.generated += movesCount;
+	for (int i = 0; i < movesCount; i++) {
+		auto	timer = profiler.start();
+		const uint32_t	child = arena.create(ctx, state, moves[i], curr);
+		profiler.stop(HEURISTIC_PHASE, timer);
+
+		timer = profiler.start();
+		typename NodeTable<Board>::Slot	&known = table.insert(child, inserted);
+		profiler.stop(CLOSED_SET_PHASE, timer);
+
+		closed = false;
+		if (!inserted) {
+			closed = known.isClosed();
+			// open boards are replaced only by a shorter path
+			if ((closed && !reopen) || arena[known.getNode()].getLength() <= arena[child].getLength()) {
+				arena.dropLast();
+				counters.duplicates++;
+				continue;
+			}
+			known.replace(child);
+			if (closed)
+				known.close();
+		}
+		push(child, closed);
+	}
+}
+
+template <typename Board, typename OpenList>
+void NPuzzleSolver::aStar(const SolverContext<Board> &ctx, const int *map, NP_retVal &result) {
+    NParena<Board>	arena;
+    OpenList		open(&arena, ctx.byPrice, ctx.weight);
+    NodeTable<Board>	table(&arena);
+    Profiler	profiler(ctx.profiling);
+
+    SearchCounters	counters;
+    bool	inserted;
+    int		limit;
+
+    const auto searchStart = profiler.start();
+    auto saveAll = [&]() {
+        // nothing is freed during the search, so allocated memory is the peak one
+        saveStats(profiler, searchStart, counters,
+                    arena.usedMemory() + open.usedMemory() + table.usedMemory(), result);
+    };
+    auto push = [&](uint32_t child, bool) {
+        auto timer = profiler.start();
+        open.push(child);
+        profiler.stop(OPEN_LIST_PHASE, timer);
     };
 
-    auto root = std::make_shared<State>(map);
-    open.push(std::move(root));
+    open.push(arena.create(ctx, map));
+    table.insert(open.top(), inserted);
 
     while (!open.empty()) {
-        auto curr = open.top();
+        auto timer = profiler.start();
+        uint32_t curr = open.top();
         open.pop();
+        profiler.stop(OPEN_LIST_PHASE, timer);
 
-        // If already exist in closed set
-        if (closed.find(curr) != closed.end()) {
-            // std::cout << "If already exist in closed set" << std::endl;
+        // shorter path to the board was found after the node was pushed
+        timer = profiler.start();
+        typename NodeTable<Board>::Slot &slot = table.find(curr);
+        profiler.stop(CLOSED_SET_PHASE, timer);
+        if (slot.getNode() != curr)
             continue;
-        }
+        slot.close();
 
-        if (curr->getPrice() == 0) {
-            createRetVal(open, closed, curr, 0, result);
+        const State<Board> &state = arena[curr];
+
+        if (state.getPrice() == 0) {
+            timer = profiler.start();
+            createRetVal(arena, curr, result);
+            profiler.stop(PATH_PHASE, timer);
+            saveAll();
             return;
         }
+        // open list is counted by its size, exact sum of its vectors is too slow here
+        if (++counters.expanded % BudgetWatch::period == 0 &&
+            (limit = ctx.budget.check(counters.expanded, arena.usedMemory() + table.usedMemory() +
+                                        open.size() * sizeof(uint32_t), open.size(), state.getCost())) != NO_LIMIT) {
+            saveAll();
+            throw NP_BudgetExceeded(limit);
+        }
 
-        for (int move = UP; move < LAST; move++)
-            addNewState(curr, move);
-
-        closed.insert(std::move(curr));
+        // expanded boards are never reopened
+        expandNode(ctx, arena, table, profiler, curr, false, counters, push);
+        counters.maxOpen = std::max(counters.maxOpen, open.size());
     }
 
     // can't find solution, throw an exception
     throw NP_InvalidMap();
 }
 
-NPuzzleSolver::NPuzzleSolver() {
+/*
+ * Anytime repairing A* (ARA*): weighted A* finds the first path fast, then the weight
+ * goes down by NP_ANYTIME_STEP and the search goes on from its open nodes and from boards
+ * which got a shorter path after their expansion, until the weight is 1 and the path
+ * is the shortest one. Every better path or bound is added to 'result.improvements',
+ * the bound is the weight or the path's length over the smallest cost of open nodes.
+ * Out of budget the best found path is the answer.
+ */
+template <typename Board, typename OpenList>
+void NPuzzleSolver::araStar(const SolverContext<Board> &ctx, const int *map, NP_retVal &result) {
+	NParena<Board>				arena;
+	NodeTable<Board>			table(&arena);
+	std::unique_ptr<OpenList>	open(new OpenList(&arena, false, ctx.weight));
+	std::vector<uint32_t>		inconsistent;	// expanded boards which got a shorter path
+	std::vector<uint32_t>		waiting;		// nodes for the next search
+	Profiler					profiler(ctx.profiling);
+	const auto					start = std::chrono::steady_clock::now();
+
+	int				weight = ctx.weight;
+	SearchCounters	counters;
+	uint32_t		goal = NP_NO_NODE;	// node of the finish board with the shortest known path
+	bool			inserted;
+	int				limit = NO_LIMIT;
+
+	const auto	searchStart = profiler.start();
+	auto		saveAll = [&]() {
+		saveStats(profiler, searchStart, counters,
+					arena.usedMemory() + open->usedMemory() + table.usedMemory() +
+					(inconsistent.capacity() + waiting.capacity()) * sizeof(uint32_t), result);
+	};
+	// expanded boards wait for the next search
+	auto		push = [&](uint32_t child, bool closed) {
+		if (closed) {
+			inconsistent.push_back(child);
+			return ;
+		}
+		if (arena[child].getPrice() == 0)
+			goal = child;
+
+		auto	timer = profiler.start();
+
+		open->push(child);
+		profiler.stop(OPEN_LIST_PHASE, timer);
+	};
+	// open and inconsistent nodes go to 'waiting', their smallest cost bounds the shortest path,
+	// the weight bounds it only when its search is over
+	auto		improve = [&]() {
+		int		minCost = std::numeric_limits<int>::max();
+		double	bound = (double)weight / NP_WEIGHT_UNIT;
+
+		if (limit != NO_LIMIT)
+			bound = result.improvements.empty() ? std::numeric_limits<double>::max() :
+					result.improvements.back().bound;
+
+		waiting.clear();
+		for (; !open->empty(); open->pop())
+			if (table.find(open->top()).getNode() == open->top())
+				waiting.push_back(open->top());
+		for (auto node : inconsistent)
+			if (table.find(node).getNode() == node)
+				waiting.push_back(node);
+		inconsistent.clear();
+		for (auto node : waiting)
+			minCost = std::min(minCost, arena[node].getCost());
+		bound = std::max(1.0, std::min(bound, (double)arena[goal].getLength() / minCost));
+
+		const NP_improvement	improvement = {(size_t)arena[goal].getLength(), bound,
+			std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), counters.expanded};
+
+		if (result.improvements.empty() || improvement.moves < result.improvements.back().moves ||
+			improvement.bound < result.improvements.back().bound)
+			result.improvements.push_back(improvement);
+	};
+
+	open->push(arena.create(ctx, map));
+	table.insert(open->top(), inserted);
+	if (arena[open->top()].getPrice() == 0)
+		goal = open->top();
+
+	while (true) {
+		const NodeKey	key(false, weight);
+
+		// the search goes on while some open node may lead to a better path
+		while (!open->empty() && (goal == NP_NO_NODE || key(arena[goal]) > key(arena[open->top()]))) {
+			auto		timer = profiler.start();
+			uint32_t	curr = open->top();
+
+			open->pop();
+			profiler.stop(OPEN_LIST_PHASE, timer);
+
+			timer = profiler.start();
+			typename NodeTable<Board>::Slot	&slot = table.find(curr);
+			profiler.stop(CLOSED_SET_PHASE, timer);
+			if (slot.getNode() != curr)
+				continue;
+
+			// the node stays open, so it bounds the best path
+			if (++counters.expanded % BudgetWatch::period == 0 &&
+				(limit = ctx.budget.check(counters.expanded, arena.usedMemory() + table.usedMemory() +
+											open->size() * sizeof(uint32_t), open->size(),
+											arena[curr].getCost())) != NO_LIMIT) {
+				open->push(curr);
+				break;
+			}
+			slot.close();
+
+			expandNode(ctx, arena, table, profiler, curr, true, counters, push);
+			counters.maxOpen = std::max(counters.maxOpen, open->size() + inconsistent.size());
+		}
+
+		if (goal == NP_NO_NODE) {
+			saveAll();
+			if (limit != NO_LIMIT)
+				throw NP_BudgetExceeded(limit);
+			throw NP_InvalidMap();
+		}
+		improve();
+		if (limit != NO_LIMIT || weight == NP_WEIGHT_UNIT)
+			break;
+
+		// nothing is expanded by the next search yet
+		weight = std::max(weight - NP_ANYTIME_STEP, NP_WEIGHT_UNIT);
+		open.reset(new OpenList(&arena, false, weight));
+		table.openAll();
+		for (auto node : waiting)
+			open->push(node);
+	}
+
+	auto	timer = profiler.start();
+
+	createRetVal(arena, goal, result);
+	profiler.stop(PATH_PHASE, timer);
+	saveAll();
+}
+
+// depth-first search limited by 'bound', the only node is moved in place and moved back
+template <typename Board>
+static bool idaSearch(const SolverContext<Board> &ctx, State<Board> &node, int bound, int &nextBound,
+						std::vector<int> &path, NP_retVal &result, Profiler &profiler)
+{
+	int		moves[LAST];
+	int		movesCount;
+
+	if (node.getCost() > bound) {
+		nextBound = std::min(nextBound, node.getCost());
+		return (false);
+	}
+	if (node.getPrice() == 0)
+		return (true);
+
+	if (++result.closedNodes % BudgetWatch::period == 0) {
+		result.usedMemory = sizeof(State<Board>) + path.capacity() * sizeof(int);
+
+		const int	limit = ctx.budget.check(result.closedNodes, result.usedMemory, path.size() + 1, bound);
+		if (limit != NO_LIMIT)
+			throw NPuzzleSolver::NP_BudgetExceeded(limit);
+	}
+	// open nodes of IDA* are the nodes on the current path
+	result.maxOpen = std::max(result.maxOpen, path.size() + 1);
+	movesCount = node.getMoves(ctx, moves);
+	result.generatedNodes += movesCount;
+	for (int i = 0; i < movesCount; i++) {
+		const int	parentMove = node.getMove();
+		const int	parentPrice = node.getPrice();
+
+		const auto	timer = profiler.start();
+
+		node.doMove(ctx, moves[i]);
+		profiler.stop(HEURISTIC_PHASE, timer);
+		path.push_back(moves[i]);
+		if (idaSearch(ctx, node, bound, nextBound, path, result, profiler))
+			return (true);
+		path.pop_back();
+		node.undoMove(ctx, moves[i], parentMove, parentPrice);
+	}
+	return (false);
+}
+
+/*
+ * IDA* keeps only the current path, so memory is linear in solution depth.
+ * It always looks for the shortest path, optimisation by time is ignored.
+ */
+template <typename Board>
+void NPuzzleSolver::idaStar(const SolverContext<Board> &ctx, const int *map, NP_retVal &result) {
+	State<Board>		node(ctx, map);
+	std::vector<int>	path;
+	int					bound = node.getCost();
+	Profiler			profiler(ctx.profiling);
+	auto				timer = profiler.start();
+
+	try {
+		while (true) {
+			int	nextBound = std::numeric_limits<int>::max();
+
+			if (idaSearch(ctx, node, bound, nextBound, path, result, profiler))
+				break;
+			// every branch is closed, there is no solution
+			if (nextBound == std::numeric_limits<int>::max())
+				throw NP_InvalidMap();
+			bound = nextBound;
+		}
+	}
+	catch (NP_BudgetExceeded &e) {
+		profiler.stop(EXPANSION_PHASE, timer, result.closedNodes);
+		profiler.save(result.profile);
+		throw;
+	}
+	profiler.stop(EXPANSION_PHASE, timer, result.closedNodes);
+
+	timer = profiler.start();
+	result.usedMemory = sizeof(State<Board>) + path.capacity() * sizeof(int);
+	result.path.push_back(ROOT);
+	result.path.insert(result.path.end(), path.begin(), path.end());
+	profiler.stop(PATH_PHASE, timer);
+	profiler.save(result.profile);
+}
+
+template <typename Board, typename OpenList>
+void NPuzzleSolver::hdaStar(const SolverContext<Board> &ctx, const int *map, int threads, NP_retVal &result) {
+	ParallelAStar<Board, OpenList>	search(ctx, threads);
+
+	search.solve(map, result);
+}
+
+template <typename Board>
+void NPuzzleSolver::baStar(const SolverContext<Board> &ctx, const int *map, const int *finishMap,
+							NP_retVal &result) {
+	BidirectionalAStar<Board>	search(ctx, map, finishMap);
+
+	search.solve(map, finishMap, result);
+}
+
+NPuzzleSolver::NPuzzleSolver() : profiling(false), weight(NP_DEFAULT_WEIGHT) {
 }
 
 static inline int getInversions(const int *map, int mapLength) {
@@ -109,83 +436,183 @@ static inline int getInversions(const int *map, int mapLength) {
 }
 
 bool NPuzzleSolver::isSolvable(const int *map, int mapLength, int solutionType) {
-	State	finishState(solutionType);
-	int		inversionsFin = getInversions(finishState.getMapPtr(), mapLength);
-	int		inversionsMap = getInversions(map, mapLength);
+	int		finishMap[mapLength];
+	bool	present[mapLength];
+	int		zeroIdx = -1;
 	int		size = (int)std::sqrt(mapLength);
 
 	auto	isEven = [](const int number) { return ((number & 0x1) == 0); };
-	auto	findIndexInMap = [](const int *map, const int mapLength, const int value) {
-				for (int i = 0; i < mapLength; i++)
-					if (value == map[i])
-						return (i);
-				return (-1);
-	};
 
-	for (int i = 0; i < mapLength; i++)
-		if (findIndexInMap(map, mapLength, i) == -1)
+	// every number from 0 to mapLength - 1 must be present exactly once
+	std::fill(present, present + mapLength, false);
+	for (int i = 0; i < mapLength; i++) {
+		if (map[i] < 0 || map[i] >= mapLength || present[map[i]])
 			return (false);
+		present[map[i]] = true;
+		if (map[i] == 0)
+			zeroIdx = i;
+	}
+
+	State<NP_Board64>::makeFinishMap(solutionType, size, finishMap);
+	int		inversionsFin = getInversions(finishMap, mapLength);
+	int		inversionsMap = getInversions(map, mapLength);
 
+	// for even size vertical move changes parity of inversions, so count row of empty piece
 	if (isEven(size)) {
-		int zeroIdx;
-
-		zeroIdx = findIndexInMap(map, mapLength, 0);
-		assert(zeroIdx != -1);
-		inversionsMap += zeroIdx;
-		zeroIdx = findIndexInMap(finishState.getMapPtr(), mapLength, 0);
-		assert(zeroIdx != -1);
-		inversionsFin += zeroIdx;
+		inversionsMap += zeroIdx / size;
+		inversionsFin += (std::find(finishMap, finishMap + mapLength, 0) - finishMap) / size;
 	}
 	return !(isEven(inversionsMap) ^ isEven(inversionsFin));
 }
 
-void NPuzzleSolver::solve(int heuristic, int solutionType,
-		const int *map, const int mapLength, NP_retVal &result)
+template <typename Board>
+void NPuzzleSolver::solveBoard(int heuristic, int solutionType,
+		const int *map, const int mapLength, int openList, int algorithm, int optimisation,
+		int threads, const NP_budget &budget, NP_retVal &result)
 {
-	if (mapLength < 9 ||
-		std::sqrt(mapLength) - (int)(std::sqrt(mapLength)) != 0.0)
-		throw NP_InvalidMapSize();
+	Profiler				profiler(this->profiling);
+	auto					timer = profiler.start();
+	// ordering of open list is fixed for the whole solve
+	SolverContext<Board>	ctx(mapLength, optimisation == BY_TIME);
+	int						finishMap[mapLength];
 
-	if (map == nullptr)
-		throw NP_MapisNullException();
+	ctx.budget = BudgetWatch(budget);
+	ctx.profiling = this->profiling;
+	if (optimisation == WEIGHTED || optimisation == ANYTIME)
+		ctx.weight = std::lround(this->weight * NP_WEIGHT_UNIT);
 
 	switch (heuristic) {
 		case MISPLACED_TILES:
-			State::heuristicFunc = &Heuristic::misplacedTiles;
+			ctx.heuristicFunc = &Heuristic::misplacedTiles<Board>;
+			ctx.heuristicDelta = &Heuristic::misplacedTilesDelta<Board>;
 			break;
 		case MANHATTAN_DISTANCE:
-			State::heuristicFunc = &Heuristic::manhattanDistance;
+			ctx.heuristicFunc = &Heuristic::manhattanDistance<Board>;
+			ctx.heuristicDelta = &Heuristic::manhattanDistanceDelta<Board>;
 			break;
 		case MANHATTAN_DISTANCE_PLUS_LINEAR_CONFLICTS:
-			State::heuristicFunc = &Heuristic::MDplusLinearConflicts;
+			ctx.heuristicFunc = &Heuristic::MDplusLinearConflicts<Board>;
+			ctx.heuristicDelta = &Heuristic::MDplusLinearConflictsDelta<Board>;
 			break;
 		case MISPLACED_TILES_PLUS_LINEAR_CONFLICTS:
-			State::heuristicFunc = &Heuristic::MTplusLinearConflicts;
+			ctx.heuristicFunc = &Heuristic::MTplusLinearConflicts<Board>;
+			ctx.heuristicDelta = &Heuristic::MTplusLinearConflictsDelta<Board>;
 			break;
 		case N_MAXSWAP:
-			State::heuristicFunc = &Heuristic::nMaxSwap;
+			ctx.heuristicFunc = &Heuristic::nMaxSwap<Board>;
+			ctx.heuristicDelta = &Heuristic::nMaxSwapDelta<Board>;
+			break;
+		case PATTERN_DATABASE:
+			ctx.heuristicFunc = &Heuristic::patternDatabase<Board>;
+			ctx.heuristicDelta = &Heuristic::patternDatabaseDelta<Board>;
 			break;
 		default:
 			throw NP_InvalidHeuristic();
 			break;
 	}
 
-	State::mapLength = mapLength;
-	State::mapSize = (int)std::sqrt(mapLength);
-	State::finishState = new State(solutionType);
+	// setup goes on after the validation, so it's counted as one call
+	profiler.stop(SETUP_PHASE, timer, 0);
 
+	timer = profiler.start();
 	if (!isSolvable(map, mapLength, solutionType))
 		throw NP_InvalidMap();
+	profiler.stop(VALIDATION_PHASE, timer);
+
+	timer = profiler.start();
+	State<Board>::makeFinishMap(solutionType, ctx.mapSize, finishMap);
+	ctx.heuristic.initTables(finishMap, ctx.mapSize);
+	if (heuristic == PATTERN_DATABASE)
+		ctx.heuristic.initPatterns(finishMap, ctx.mapSize, solutionType);
+	// the backward search shares the tables only if the empty piece of the map is on its finish place,
+	// without them it expands far more nodes than A*
+	if (algorithm == BA_STAR && heuristic == PATTERN_DATABASE &&
+		!Heuristic().initReversed(ctx.heuristic, finishMap, map))
+		throw NP_InvalidHeuristic();
+	profiler.stop(SETUP_PHASE, timer);
+	profiler.save(result.profile);
+
+	if (algorithm == IDA_STAR)
+		idaStar<Board>(ctx, map, result);
+	else if (algorithm == BA_STAR)
+		baStar<Board>(ctx, map, finishMap, result);
+	else if (optimisation == ANYTIME && openList == BINARY_HEAP)
+		araStar<Board, HeapOpenList<Board>>(ctx, map, result);
+	else if (optimisation == ANYTIME)
+		araStar<Board, BucketOpenList<Board>>(ctx, map, result);
+	else if (algorithm == HDA_STAR && openList == BINARY_HEAP)
+		hdaStar<Board, HeapOpenList<Board>>(ctx, map, threads, result);
+	else if (algorithm == HDA_STAR)
+		hdaStar<Board, BucketOpenList<Board>>(ctx, map, threads, result);
+	else if (openList == BINARY_HEAP)
+		aStar<Board, HeapOpenList<Board>>(ctx, map, result);
+	else
+		aStar<Board, BucketOpenList<Board>>(ctx, map, result);
+
+	if (verboseLevel & ALGO)
+		checkPath(ctx, State<Board>(ctx, map), result);
+}
 
-	aStar(map, result);
-	if (verboseLevel & ALGO) {
-		try {
-			checkPath(State(map), result);
-		}
-		catch (std::exception &e) {
-			std::cout << "Error: " << e.what() << std::endl;
-		}
-	}
+void NPuzzleSolver::solve(int heuristic, int solutionType,
+		const int *map, const int mapLength, NP_retVal &result, int openList, int algorithm,
+		int optimisation, int threads, const NP_budget &budget)
+{
+	Profiler	profiler(this->profiling);
+	auto		timer = profiler.start();
+
+	result.profile.enabled = this->profiling;
+	if (mapLength < 9 ||
+		std::sqrt(mapLength) - (int)(std::sqrt(mapLength)) != 0.0)
+		throw NP_InvalidMapSize();
+
+	if (map == nullptr)
+		throw NP_MapisNullException();
 
-	delete State::finishState;
+	if (openList != BUCKET_QUEUE && openList != BINARY_HEAP)
+		throw NP_InvalidOpenList();
+
+	if (algorithm != A_STAR && algorithm != IDA_STAR && algorithm != HDA_STAR && algorithm != BA_STAR)
+		throw NP_InvalidAlgorithm();
+
+	if (optimisation < BY_LENGTH || optimisation > ANYTIME ||
+		(optimisation > BY_TIME && algorithm != A_STAR))
+		throw NP_InvalidOptimisation();
+	if (optimisation > BY_TIME && !(this->weight >= 1.0 && this->weight <= NP_MAX_WEIGHT))
+		throw NP_InvalidWeight();
+
+	if (threads < 0)
+		throw NP_InvalidThreads();
+	if (threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+
+	if (mapLength > NP_Board64::maxLength)
+		throw NP_InvalidMapSize();
+	profiler.stop(VALIDATION_PHASE, timer);
+	profiler.save(result.profile);
+
+	// clock() sums time of every thread, parallel search needs wall time
+	auto	start = std::chrono::steady_clock::now();
+
+	auto	saveTime = [&]() {
+		std::chrono::duration<double>	elapsed = std::chrono::steady_clock::now() - start;
+
+		result.elapsedTime = elapsed.count();
+		if (result.elapsedTime > 0)
+			result.nodesPerSecond = result.closedNodes / result.elapsedTime;
+	};
+
+	try {
+		// pick the most compact board which can hold the map
+		if (mapLength <= NP_Board16::maxLength)
+			solveBoard<NP_Board16>(heuristic, solutionType, map, mapLength, openList, algorithm,
+									optimisation, threads, budget, result);
+		else
+			solveBoard<NP_Board64>(heuristic, solutionType, map, mapLength, openList, algorithm,
+									optimisation, threads, budget, result);
+	}
+	catch (NP_BudgetExceeded &e) {
+		saveTime();
+		throw;
+	}
+	saveTime();
 }
@@ -4,31 +4,94 @@
 #include <exception>
 #include <list>
 #include <queue>
-#include <unordered_set>
+#include <vector>
+#include "Budget.hpp"
 #include "State.hpp"
+#include "NodeTable.hpp"
+#include "OpenList.hpp"
+#include "Profiler.hpp"
+#include "SolverContext.hpp"
 
-typedef std::priority_queue<std::shared_ptr<State>, std::vector<std::shared_ptr<State>>, CompareState>  NPqueue;
-typedef std::unordered_set<std::shared_ptr<State>, HashState, EqualState>                               NPset;
+enum openListTypes { BUCKET_QUEUE, BINARY_HEAP };
+
+enum algorithms { A_STAR, IDA_STAR, HDA_STAR, BA_STAR };
+
+// WEIGHTED and ANYTIME are searches of A*, see NPuzzleSolver::setWeight
+enum optimisations { BY_LENGTH, BY_TIME, WEIGHTED, ANYTIME };
+
+#define NP_DEFAULT_WEIGHT	2.0
+#define NP_MAX_WEIGHT		10.0
+#define NP_ANYTIME_STEP		5	// decrease of the weight after every path of anytime search, in 1 / NP_WEIGHT_UNIT
+
+// path found by anytime search, it's at most 'bound' times longer than the shortest one
+class NP_improvement {
+public:
+	size_t	moves;
+	double	bound;
+	double	time;		// seconds since the search started
+	size_t	expanded;
+};
+
+template <typename Board>
+using NParena = NodeArena<State<Board>>;
 
 class NP_retVal {
 public:
 	std::list<int>	path;
-	size_t			maxOpen;
-	size_t			closedNodes;
-	size_t			usedMemory;
+	size_t			maxOpen;		// peak size of the open list
+	size_t			closedNodes;	// expanded nodes
+	size_t			generatedNodes;
+	size_t			duplicates;	// children dropped because their board was known with a shorter path
+	size_t			usedMemory;		// peak bytes of nodes, open list and table of boards
+	double			elapsedTime;	// wall time of the solve in seconds
+	double			nodesPerSecond;	// expanded nodes per second
+	NP_profile		profile;		// phases of the solve, if profiling is on
+	std::vector<NP_improvement>	improvements;	// paths of anytime search, the last one is 'path'
+
+	NP_retVal() : maxOpen(0), closedNodes(0), generatedNodes(0), duplicates(0), usedMemory(0),
+		elapsedTime(0), nodesPerSecond(0) {};
 };
 
 class NPuzzleSolver {
 
 private:
-	void	aStar(const int *map, NP_retVal &result);
-	void	checkPath(const State &root, const NP_retVal &result) const;
+	bool	profiling;
+	double	weight;
+
+	template <typename Board, typename OpenList>
+	void	aStar(const SolverContext<Board> &ctx, const int *map, NP_retVal &result);
+	template <typename Board, typename OpenList>
+	void	araStar(const SolverContext<Board> &ctx, const int *map, NP_retVal &result);
+	template <typename Board>
+	void	idaStar(const SolverContext<Board> &ctx, const int *map, NP_retVal &result);
+	template <typename Board, typename OpenList>
+	void	hdaStar(const SolverContext<Board> &ctx, const int *map, int threads, NP_retVal &result);
+	template <typename Board>
+	void	baStar(const SolverContext<Board> &ctx, const int *map, const int *finishMap, NP_retVal &result);
+	template <typename Board>
+	bool	checkPath(const SolverContext<Board> &ctx, const State<Board> &root,
+						const NP_retVal &result) const;
 	bool	isSolvable(const int *map, int mapSize, int solutionType);
+	template <typename Board>
+	void	solveBoard(int heuristic, int solutionType, const int *map, const int mapLength,
+						int openList, int algorithm, int optimisation, int threads,
+						const NP_budget &budget, NP_retVal &result);
 
 public:
 	NPuzzleSolver();
 	~NPuzzleSolver() {};
-	void	solve(int heuristic, int solutionType, const int *map, const int mapSize, NP_retVal &result);
+	// timers of phases of the solve, they cost a branch per operation when off
+	void	setProfiling(bool enabled) { this->profiling = enabled; }
+	// weight of the heuristic for WEIGHTED, the first one for ANYTIME, from 1 to NP_MAX_WEIGHT
+	void	setWeight(double weight) { this->weight = weight; }
+	// every call has its own context, so one solver can be used from several threads
+	// 'threads' is used by HDA_STAR only, 0 means amount of cores
+	// 'openList' isn't used by IDA_STAR and BA_STAR, they have their own orders
+	// WEIGHTED and ANYTIME work with A_STAR only, ANYTIME out of budget gives the best found path
+	// out of budget solve throws NP_BudgetExceeded, 'result' keeps stats of the search
+	void	solve(int heuristic, int solutionType, const int *map, const int mapSize, NP_retVal &result,
+					int openList = BUCKET_QUEUE, int algorithm = A_STAR, int optimisation = BY_TIME,
+					int threads = 0, const NP_budget &budget = NP_budget());
 
 	class	NP_MapisNullException : public std::exception {
 	public:
@@ -49,6 +112,45 @@ public:
 	public:
 		virtual const char	*what() const throw() {return ("Invalid heuristic");};
 	};
+
+	class	NP_InvalidOpenList : public std::exception {
+	public:
+		virtual const char	*what() const throw() {return ("Invalid open list type");};
+	};
+
+	class	NP_InvalidAlgorithm : public std::exception {
+	public:
+		virtual const char	*what() const throw() {return ("Invalid algorithm");};
+	};
+
+	class	NP_InvalidOptimisation : public std::exception {
+	public:
+		virtual const char	*what() const throw() {return ("Invalid optimisation");};
+	};
+
+	class	NP_InvalidWeight : public std::exception {
+	public:
+		virtual const char	*what() const throw() {return ("Invalid weight");};
+	};
+
+	class	NP_InvalidThreads : public std::exception {
+	public:
+		virtual const char	*what() const throw() {return ("Invalid amount of threads");};
+	};
+
+	class	NP_BudgetExceeded : public std::exception {
+		int		limit;	// budgetLimits
+
+	public:
+		explicit NP_BudgetExceeded(int limit) : limit(limit) {};
+		int					getLimit() const { return (limit); }
+		virtual const char	*what() const throw() {
+			static const char	*messages[] = {"Time limit exceeded", "Node limit exceeded",
+												"Memory limit exceeded", "Solve was cancelled"};
+
+			return (messages[limit]);
+		};
+	};
 };
 
 #endif /* NPUZZLE_SOLVER_HPP */
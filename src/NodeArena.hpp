@@ -0,0 +1,70 @@
+#ifndef NODE_ARENA_HPP
+#define NODE_ARENA_HPP
+
+#include <cstdint>
+#include <exception>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#define NP_NO_NODE	0xFFFFFFFFu
+
+/*
+ * Bump allocator for search nodes: nodes are placed one after another
+ * into fixed-size slabs and addressed by 32-bit index.
+ * Slabs never move, so references to nodes stay valid until clear().
+ * Nodes are never destroyed one by one, all memory is released at once.
+ */
+template <typename T>
+class NodeArena
+{
+	static const uint32_t	slabShift = 16;
+	static const uint32_t	slabSize = 1u << slabShift;	// nodes in one slab
+	static const uint32_t	slabMask = slabSize - 1;
+
+	static_assert(std::is_trivially_destructible<T>::value, "arena never calls destructors");
+
+	std::vector<T *>	slabs;
+	uint32_t			count;
+
+	//disable copy constructor;
+	NodeArena(const NodeArena &rhs);
+	NodeArena	&operator=(const NodeArena &rhs);
+
+public:
+	NodeArena() : count(0) {};
+	~NodeArena() { clear(); };
+
+	template <typename... Args>
+	uint32_t	create(Args&&... args) {
+		if (count == NP_NO_NODE)
+			throw NP_ArenaOverflow();
+		if ((count >> slabShift) == slabs.size())
+			slabs.push_back(static_cast<T *>(::operator new(sizeof(T) * slabSize)));
+		new (&slabs[count >> slabShift][count & slabMask]) T(std::forward<Args>(args)...);
+		return (count++);
+	}
+
+	// forget the last created node, e.g. duplicate found right after its creation
+	void		dropLast() { count--; }
+
+	T			&operator[](uint32_t i) { return (slabs[i >> slabShift][i & slabMask]); }
+	const T		&operator[](uint32_t i) const { return (slabs[i >> slabShift][i & slabMask]); }
+	size_t		size() const { return (count); }
+	size_t		usedMemory() const { return (slabs.size() * slabSize * sizeof(T)); }
+
+	void		clear() {
+		for (auto slab : slabs)
+			::operator delete(slab);
+		slabs.clear();
+		count = 0;
+	}
+
+	class	NP_ArenaOverflow : public std::exception {
+	public:
+		virtual const char	*what() const throw() {return ("Too many nodes in arena");};
+	};
+};
+
+#endif // NODE_ARENA_HPP
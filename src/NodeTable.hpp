@@ -0,0 +1,127 @@
+#ifndef NODE_TABLE_HPP
+#define NODE_TABLE_HPP
+
+#include <cstdint>
+#include <vector>
+#include "NodeArena.hpp"
+#include "State.hpp"
+
+/*
+ * Flat hash table with linear probing: board -> node with the shortest known path to it.
+ * Slot keeps index of the node and high bits of its Zobrist hash, so most
+ * of the other boards are skipped without reading the arena. Length of the path
+ * is taken from the node. Boards are never removed, only their nodes are replaced.
+ */
+template <typename Board>
+class NodeTable
+{
+	static const uint32_t	closedBit = 1;
+
+public:
+	class Slot {
+		uint32_t	node;
+		uint32_t	tag;	// high bits of the hash, the lowest one marks expanded node
+
+		friend class	NodeTable;
+
+	public:
+		uint32_t	getNode() const { return (this->node); }
+		bool		isClosed() const { return (this->tag & closedBit); }
+		void		close() { this->tag |= closedBit; }
+		// node with a shorter path, the board is open again
+		void		replace(uint32_t node) {
+			this->node = node;
+			this->tag &= ~closedBit;
+		}
+	};
+
+private:
+	const NodeArena<State<Board>>	*arena;
+	std::vector<Slot>				slots;	// size is a power of two
+	size_t							count;
+
+	//disable copy constructor;
+	NodeTable(const NodeTable &rhs);
+	NodeTable	&operator=(const NodeTable &rhs);
+
+	static uint32_t	tagOf(uint64_t hash) { return ((uint32_t)(hash >> 32) & ~closedBit); }
+
+	// slot with the board of the node, or empty slot where it should be placed
+	Slot	&probe(uint32_t node) {
+		const State<Board>	&state = (*arena)[node];
+		const uint32_t		tag = tagOf(state.getHash());
+		const size_t		mask = slots.size() - 1;
+		size_t				i = state.getHash() & mask;
+
+		while (slots[i].node != NP_NO_NODE) {
+			if (slots[i].node == node ||
+				((slots[i].tag & ~closedBit) == tag &&
+				(*arena)[slots[i].node].getBoard() == state.getBoard()))
+				break;
+			i = (i + 1) & mask;
+		}
+		return (slots[i]);
+	}
+
+	void	grow() {
+		std::vector<Slot>	old(slots.size() * 2);
+
+		old.swap(slots);
+		for (auto &slot : slots)
+			slot.node = NP_NO_NODE;
+		for (auto const &slot : old)
+			if (slot.node != NP_NO_NODE)
+				probe(slot.node) = slot;
+	}
+
+public:
+	explicit NodeTable(const NodeArena<State<Board>> *arena, size_t capacity = 1 << 12)
+		: arena(arena), slots(capacity), count(0)
+	{
+		for (auto &slot : slots)
+			slot.node = NP_NO_NODE;
+	}
+
+	// slot of the node's board, the node takes it if the board is new
+	Slot	&insert(uint32_t node, bool &inserted) {
+		// at most 3/4 full, so probes stay short
+		if ((count + 1) * 4 > slots.size() * 3)
+			grow();
+
+		Slot	&slot = probe(node);
+
+		inserted = (slot.node == NP_NO_NODE);
+		if (inserted) {
+			slot.node = node;
+			slot.tag = tagOf((*arena)[node].getHash());
+			count++;
+		}
+		return (slot);
+	}
+
+	// board of the node must be in the table
+	Slot	&find(uint32_t node) { return (probe(node)); }
+
+	// node of a board from another arena with the same Zobrist keys, NP_NO_NODE if unknown
+	uint32_t	lookup(const Board &board, uint64_t hash) const {
+		const uint32_t	tag = tagOf(hash);
+		const size_t	mask = slots.size() - 1;
+
+		for (size_t i = hash & mask; slots[i].node != NP_NO_NODE; i = (i + 1) & mask) {
+			if ((slots[i].tag & ~closedBit) == tag && (*arena)[slots[i].node].getBoard() == board)
+				return (slots[i].node);
+		}
+		return (NP_NO_NODE);
+	}
+
+	// every board is open again, e.g. for the next search of anytime A*
+	void	openAll() {
+		for (auto &slot : slots)
+			slot.tag &= ~closedBit;
+	}
+
+	size_t	size() const { return (count); }
+	size_t	usedMemory() const { return (slots.size() * sizeof(Slot)); }
+};
+
+#endif // NODE_TABLE_HPP
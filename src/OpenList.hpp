@@ -0,0 +1,235 @@
+#ifndef OPEN_LIST_HPP
+#define OPEN_LIST_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "State.hpp"
+
+/*
+ * Open lists keep indexes of nodes in NodeArena.
+ * Both of them pop the node with the smallest key (see NodeKey: cost, price if 'byPrice',
+ * or weighted cost), and from nodes with equal keys the one with the smallest length.
+ */
+
+template <typename Board>
+class HeapOpenList
+{
+	// heap on a plain vector instead of priority_queue, so its memory can be counted
+	std::vector<uint32_t>	heap;
+	CompareState<Board>		compare;
+
+public:
+	HeapOpenList(const NodeArena<State<Board>> *arena, bool byPrice, int weight = NP_WEIGHT_UNIT)
+		: compare(arena, byPrice, weight) {};
+
+	void		push(uint32_t node) {
+		heap.push_back(node);
+		std::push_heap(heap.begin(), heap.end(), compare);
+	}
+	uint32_t	top() const { return (heap.front()); }
+	void		pop() {
+		std::pop_heap(heap.begin(), heap.end(), compare);
+		heap.pop_back();
+	}
+	bool		empty() const { return (heap.empty()); }
+	size_t		size() const { return (heap.size()); }
+	size_t		usedMemory() const { return (heap.capacity() * sizeof(uint32_t)); }
+};
+
+/*
+ * Two-level bucket list: keys and lengths are small integers,
+ * so nodes are put into buckets by key and then by length, push and pop are O(1).
+ */
+template <typename Board>
+class BucketOpenList
+{
+	struct Bucket {
+		std::vector<std::vector<uint32_t>>	byLength;
+		size_t								size;
+		size_t								minLength;
+
+		Bucket() : size(0), minLength(0) {};
+	};
+
+	const NodeArena<State<Board>>	*arena;
+	const NodeKey					nodeKey;
+	std::vector<Bucket>				buckets;
+	size_t							minKey;
+	size_t							count;
+
+	// move cursors to the first non-empty bucket
+	void	advance() {
+		if (count == 0)
+			return ;
+		while (buckets[minKey].size == 0)
+			minKey++;
+
+		Bucket	&bucket = buckets[minKey];
+		while (bucket.byLength[bucket.minLength].empty())
+			bucket.minLength++;
+	}
+
+public:
+	BucketOpenList(const NodeArena<State<Board>> *arena, bool byPrice, int weight = NP_WEIGHT_UNIT)
+		: arena(arena), nodeKey(byPrice, weight), minKey(0), count(0) {};
+
+	void		push(uint32_t node) {
+		const State<Board>	&state = (*arena)[node];
+		const size_t		key = nodeKey(state);
+		const size_t		length = state.getLength();
+
+		if (key >= buckets.size())
+			buckets.resize(key + 1);
+
+		Bucket	&bucket = buckets[key];
+		if (length >= bucket.byLength.size())
+			bucket.byLength.resize(length + 1);
+		bucket.byLength[length].push_back(node);
+
+		if (bucket.size++ == 0 || length < bucket.minLength)
+			bucket.minLength = length;
+		if (count++ == 0 || key < minKey)
+			minKey = key;
+	}
+
+	uint32_t	top() const {
+		const Bucket	&bucket = buckets[minKey];
+
+		return (bucket.byLength[bucket.minLength].back());
+	}
+
+	void		pop() {
+		Bucket	&bucket = buckets[minKey];
+
+		bucket.byLength[bucket.minLength].pop_back();
+		bucket.size--;
+		count--;
+		advance();
+	}
+
+	bool		empty() const { return (count == 0); }
+	size_t		size() const { return (count); }
+
+	// vectors never shrink, so it's the peak memory too
+	size_t		usedMemory() const {
+		size_t	bytes = buckets.capacity() * sizeof(Bucket);
+
+		for (auto const &bucket : buckets) {
+			bytes += bucket.byLength.capacity() * sizeof(bucket.byLength[0]);
+			for (auto const &nodes : bucket.byLength)
+				bytes += nodes.capacity() * sizeof(uint32_t);
+		}
+		return (bytes);
+	}
+};
+
+/*
+ * Open list of a side of bidirectional search (MM): pops the smallest max(cost, 2 * length),
+ * so neither side goes much beyond the middle of the path, from equal keys the one
+ * with the smallest length. Nodes are counted by cost and by length too, the smallest
+ * of them bound paths through the side. Nodes left behind by a shorter path to their board
+ * stay counted until they are popped, so bounds are only lower than the exact ones.
+ * With 'byPrice' the key is the price.
+ */
+template <typename Board>
+class MeetingOpenList
+{
+	const NodeArena<State<Board>>			*arena;
+	const bool								byPrice;
+	std::vector<std::vector<std::vector<uint32_t>>>	buckets;	// [key][length] -> nodes
+	std::vector<size_t>						keys;		// [key] -> amount of nodes
+	std::vector<size_t>						costs;
+	std::vector<size_t>						lengths;
+	size_t									minKey, minCost, minLength, keyMinLength;
+	size_t									count;
+
+	size_t	keyOf(const State<Board> &state) const {
+		if (byPrice)
+			return (state.getPrice());
+		return (std::max(state.getCost(), 2 * state.getLength()));
+	}
+
+	void	add(std::vector<size_t> &counts, size_t &min, size_t value) {
+		if (value >= counts.size())
+			counts.resize(value + 1, 0);
+		counts[value]++;
+		if (count == 0 || value < min)
+			min = value;
+	}
+
+	// move cursors to the smallest counted values
+	void	advance() {
+		const size_t	key = minKey;
+
+		if (count == 0)
+			return ;
+		while (keys[minKey] == 0)
+			minKey++;
+		while (costs[minCost] == 0)
+			minCost++;
+		while (lengths[minLength] == 0)
+			minLength++;
+		// pushes lower the cursor of the smallest key themselves
+		if (minKey != key)
+			keyMinLength = 0;
+		while (buckets[minKey][keyMinLength].empty())
+			keyMinLength++;
+	}
+
+public:
+	MeetingOpenList(const NodeArena<State<Board>> *arena, bool byPrice)
+		: arena(arena), byPrice(byPrice), minKey(0), minCost(0), minLength(0), keyMinLength(0), count(0) {};
+
+	void		push(uint32_t node) {
+		const State<Board>	&state = (*arena)[node];
+		const size_t		key = keyOf(state);
+		const size_t		length = state.getLength();
+
+		if (key >= buckets.size())
+			buckets.resize(key + 1);
+		if (length >= buckets[key].size())
+			buckets[key].resize(length + 1);
+		buckets[key][length].push_back(node);
+		if (count == 0 || key < minKey || (key == minKey && length < keyMinLength))
+			keyMinLength = length;
+		add(keys, minKey, key);
+		add(costs, minCost, state.getCost());
+		add(lengths, minLength, length);
+		count++;
+	}
+
+	uint32_t	top() const { return (buckets[minKey][keyMinLength].back()); }
+
+	void		pop() {
+		const State<Board>	&state = (*arena)[top()];
+
+		costs[state.getCost()]--;
+		lengths[state.getLength()]--;
+		keys[minKey]--;
+		buckets[minKey][keyMinLength].pop_back();
+		count--;
+		advance();
+	}
+
+	bool		empty() const { return (count == 0); }
+	size_t		size() const { return (count); }
+	// lower bounds of open nodes, the list must not be empty
+	int			getMinKey() const { return (minKey); }
+	int			getMinCost() const { return (minCost); }
+	int			getMinLength() const { return (minLength); }
+
+	size_t		usedMemory() const {
+		size_t	bytes = buckets.capacity() * sizeof(buckets[0]) +
+						(keys.capacity() + costs.capacity() + lengths.capacity()) * sizeof(size_t);
+
+		for (auto const &bucket : buckets) {
+			bytes += bucket.capacity() * sizeof(bucket[0]);
+			for (auto const &nodes : bucket)
+				bytes += nodes.capacity() * sizeof(uint32_t);
+		}
+		return (bytes);
+	}
+};
+
+#endif // OPEN_LIST_HPP
@@ -0,0 +1,342 @@
+#ifndef PARALLEL_A_STAR_HPP
+#define PARALLEL_A_STAR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "MPSCQueue.hpp"
+#include "NPuzzleSolver.hpp"
+#include "SolverContext.hpp"
+
+#define NP_NO_PARENT	0xFFFFFFFFFFFFFFFFull
+
+/*
+ * Hash distributed A* (HDA*): every board has an owner thread chosen by hash.
+ * The owner keeps the board in its own arena, open list and table of known boards,
+ * so threads share nothing but inboxes with batches of nodes.
+ * Node of another thread is addressed by (thread << 32 | index in its arena).
+ *
+ * With optimisation by paths' length threads go on after the first solution
+ * while they have nodes cheaper than the best found path, search ends when every
+ * thread is idle and no batch is in flight. Threads don't expand nodes in global order,
+ * so an expanded board is opened again when it comes with a shorter path.
+ * With optimisation by time the first solution stops every thread.
+ */
+template <typename Board, typename OpenList>
+class ParallelAStar
+{
+	struct Entry {
+		Board		board;
+		uint64_t	hash;
+		uint64_t	parent;
+		int			price;
+		int			length;
+		uint8_t		move;
+		uint8_t		blank;
+	};
+
+	typedef std::vector<Entry>	Batch;
+
+	static const size_t	batchSize = 64;		// nodes for one thread in one push
+	static const size_t	flushPeriod = 32;	// expansions between sends of every outbox
+
+	struct Worker {
+		NodeArena<State<Board>>		arena;
+		OpenList					open;
+		NodeTable<Board>			table;
+		std::vector<uint64_t>		parents;	// [node] -> parent
+		MPSCQueue<Batch>			inbox;
+		std::vector<Batch>			outbox;		// [thread] -> nodes owned by it
+		size_t						expanded;
+		size_t						generated;
+		size_t						duplicates;
+		size_t						maxOpen;
+		size_t						reportedMemory;	// part of 'totalMemory' added by this thread
+		Profiler					profiler;
+
+		Worker(size_t threads, bool byPrice, bool profiling)
+			: open(&arena, byPrice), table(&arena), outbox(threads), expanded(0), generated(0),
+			duplicates(0), maxOpen(0), reportedMemory(0), profiler(profiling) {};
+	};
+
+	const SolverContext<Board>				&ctx;
+	std::vector<std::unique_ptr<Worker>>	workers;
+
+	std::atomic<int>		incumbent;	// length of the best found path
+	std::atomic<long>		pending;	// batches pushed, but not received yet
+	std::atomic<bool>		done;
+	std::atomic<size_t>		totalExpanded;	// of every thread, for the budget
+	std::atomic<size_t>		totalMemory;
+	std::mutex				mutex;		// guards idle, goal, limit and error
+	std::condition_variable	wake;
+	size_t					idle;
+	uint64_t				goal;
+	int						limit;		// budgetLimits
+	std::exception_ptr		error;
+
+	//disable copy constructor;
+	ParallelAStar(const ParallelAStar &rhs);
+	ParallelAStar	&operator=(const ParallelAStar &rhs);
+
+	static uint64_t	nodeId(size_t worker, uint32_t node) { return (((uint64_t)worker << 32) | node); }
+
+	size_t	owner(uint64_t hash) const {
+		// high bits of the hash, the table of known boards uses low ones
+		return ((hash >> 32) % workers.size());
+	}
+
+	bool	hasWork(Worker &self) const {
+		if (self.open.empty())
+			return (false);
+		return (ctx.byPrice ||
+				self.arena[self.open.top()].getCost() < incumbent.load(std::memory_order_relaxed));
+	}
+
+	void	insert(Worker &self, const Entry &entry) {
+		if (!ctx.byPrice && entry.price + entry.length >= incumbent.load(std::memory_order_relaxed))
+			return;
+
+		const uint32_t	node = self.arena.create(entry.board, entry.hash, entry.blank, entry.price,
+												entry.length, entry.move);
+		bool			inserted;
+		auto			timer = self.profiler.start();
+
+		typename NodeTable<Board>::Slot	&known = self.table.insert(node, inserted);
+		self.profiler.stop(CLOSED_SET_PHASE, timer);
+		if (!inserted) {
+			// greedy search doesn't reopen expanded boards, like A* doesn't
+			if ((ctx.byPrice && known.isClosed()) ||
+				self.arena[known.getNode()].getLength() <= entry.length) {
+				self.arena.dropLast();
+				self.duplicates++;
+				return;
+			}
+			known.replace(node);
+		}
+		self.parents.push_back(entry.parent);
+		timer = self.profiler.start();
+		self.open.push(node);
+		self.profiler.stop(OPEN_LIST_PHASE, timer);
+		self.maxOpen = std::max(self.maxOpen, self.open.size());
+	}
+
+	void	send(size_t to, Batch &batch) {
+		pending.fetch_add(1);
+		workers[to]->inbox.push(std::move(batch));
+		batch.clear();
+		wake.notify_all();
+	}
+
+	void	flush(Worker &self) {
+		for (size_t to = 0; to < self.outbox.size(); to++)
+			if (!self.outbox[to].empty())
+				send(to, self.outbox[to]);
+	}
+
+	void	receive(Worker &self) {
+		typename MPSCQueue<Batch>::Node	*node = self.inbox.popAll();
+
+		while (node != nullptr) {
+			typename MPSCQueue<Batch>::Node	*next = node->next;
+
+			for (auto const &entry : node->value)
+				insert(self, entry);
+			delete node;
+			// counted only when nodes are in the open list, so idle threads can't miss them
+			pending.fetch_sub(1);
+			node = next;
+		}
+	}
+
+	void	foundGoal(int length, uint64_t node) {
+		std::lock_guard<std::mutex>	lock(mutex);
+
+		if (length < incumbent.load()) {
+			incumbent.store(length);
+			goal = node;
+		}
+		if (ctx.byPrice) {
+			done.store(true);
+			wake.notify_all();
+		}
+	}
+
+	// called once per BudgetWatch::period expansions of the thread, 'cost' is the one of its node
+	void	checkBudget(Worker &self, int cost) {
+		// arena and table only grow, so every thread adds just its growth
+		const size_t	used = self.arena.usedMemory() + self.table.usedMemory();
+		const size_t	memory = totalMemory.fetch_add(used - self.reportedMemory) + used - self.reportedMemory;
+		const size_t	expanded = totalExpanded.fetch_add(BudgetWatch::period) + BudgetWatch::period;
+		// other threads change their lists, so every list is taken as long as this one
+		const int		hit = ctx.budget.check(expanded, memory, self.open.size() * workers.size(), cost);
+
+		self.reportedMemory = used;
+		if (hit != NO_LIMIT) {
+			std::lock_guard<std::mutex>	lock(mutex);
+
+			if (limit == NO_LIMIT)
+				limit = hit;
+			done.store(true);
+			wake.notify_all();
+		}
+	}
+
+	void	expand(size_t w, Worker &self) {
+		auto				timer = self.profiler.start();
+		const uint32_t		curr = self.open.top();
+		const State<Board>	&state = self.arena[curr];
+		int					moves[LAST];
+		int					movesCount;
+
+		self.open.pop();
+		self.profiler.stop(OPEN_LIST_PHASE, timer);
+		// shorter path to the board was found after the node was pushed
+		timer = self.profiler.start();
+		typename NodeTable<Board>::Slot	&slot = self.table.find(curr);
+		self.profiler.stop(CLOSED_SET_PHASE, timer);
+		if (slot.getNode() != curr)
+			return;
+		slot.close();
+
+		if (state.getPrice() == 0) {
+			foundGoal(state.getLength(), nodeId(w, curr));
+			return;
+		}
+
+		if (++self.expanded % BudgetWatch::period == 0)
+			checkBudget(self, state.getCost());
+		movesCount = state.getMoves(ctx, moves);
+		self.generated += movesCount;
+		for (int i = 0; i < movesCount; i++) {
+			timer = self.profiler.start();
+			const State<Board>	child(ctx, state, moves[i]);
+			self.profiler.stop(HEURISTIC_PHASE, timer);
+			const Entry			entry = {child.getBoard(), child.getHash(), nodeId(w, curr),
+										child.getPrice(), child.getLength(), (uint8_t)child.getMove(),
+										(uint8_t)child.getBlank()};
+			const size_t		to = owner(entry.hash);
+
+			if (to == w)
+				insert(self, entry);
+			else if (ctx.byPrice || child.getCost() < incumbent.load(std::memory_order_relaxed)) {
+				self.outbox[to].push_back(entry);
+				if (self.outbox[to].size() >= batchSize)
+					send(to, self.outbox[to]);
+			}
+		}
+	}
+
+	void	run(size_t w) {
+		Worker	&self = *workers[w];
+		size_t	expansions = 0;
+
+		try {
+			while (!done.load()) {
+				// waiting for nodes isn't counted, expansions are added by solve()
+				auto	timer = self.profiler.start();
+
+				receive(self);
+				if (hasWork(self)) {
+					expand(w, self);
+					if (++expansions % flushPeriod == 0)
+						flush(self);
+					self.profiler.stop(EXPANSION_PHASE, timer, 0);
+					continue;
+				}
+				flush(self);
+				self.profiler.stop(EXPANSION_PHASE, timer, 0);
+
+				std::unique_lock<std::mutex>	lock(mutex);
+				if (++idle == workers.size() && pending.load() == 0) {
+					done.store(true);
+					wake.notify_all();
+					return;
+				}
+				// pushes don't take the mutex, so wake up from time to time
+				if (self.inbox.empty() && !done.load())
+					wake.wait_for(lock, std::chrono::milliseconds(1));
+				idle--;
+			}
+		}
+		catch (...) {
+			std::lock_guard<std::mutex>	lock(mutex);
+
+			if (!error)
+				error = std::current_exception();
+			done.store(true);
+			wake.notify_all();
+		}
+	}
+
+public:
+	ParallelAStar(const SolverContext<Board> &ctx, size_t threads)
+		: ctx(ctx), incumbent(std::numeric_limits<int>::max()), pending(0), done(false),
+		totalExpanded(0), totalMemory(0), idle(0), goal(NP_NO_PARENT), limit(NO_LIMIT)
+	{
+		for (size_t i = 0; i < threads; i++)
+			workers.emplace_back(new Worker(threads, ctx.byPrice, ctx.profiling));
+	}
+
+	void	solve(const int *map, NP_retVal &result) {
+		const State<Board>			root(ctx, map);
+		const Entry					entry = {root.getBoard(), root.getHash(), NP_NO_PARENT,
+											root.getPrice(), 0, ROOT, (uint8_t)root.getBlank()};
+		std::vector<std::thread>	threads;
+
+		insert(*workers[owner(entry.hash)], entry);
+		for (size_t w = 0; w < workers.size(); w++)
+			threads.emplace_back(&ParallelAStar::run, this, w);
+		for (auto &thread : threads)
+			thread.join();
+
+		if (error)
+			std::rethrow_exception(error);
+
+		// peaks of threads are summed, they may be reached at different moments
+		for (auto const &worker : workers) {
+			result.maxOpen += worker->maxOpen;
+			result.closedNodes += worker->expanded;
+			result.generatedNodes += worker->generated;
+			result.duplicates += worker->duplicates;
+			result.usedMemory += worker->arena.usedMemory() +
+								worker->parents.capacity() * sizeof(uint64_t) +
+								worker->open.usedMemory() + worker->table.usedMemory();
+			for (auto const &batch : worker->outbox)
+				result.usedMemory += batch.capacity() * sizeof(Entry);
+			worker->profiler.save(result.profile);
+			if (result.profile.enabled)
+				result.profile.calls[EXPANSION_PHASE] += worker->expanded;
+		}
+
+		// found path may be not the shortest one, if the search was stopped
+		if (limit != NO_LIMIT)
+			throw NPuzzleSolver::NP_BudgetExceeded(limit);
+		if (goal == NP_NO_PARENT)
+			throw NPuzzleSolver::NP_InvalidMap();
+
+		Profiler	profiler(ctx.profiling);
+		const auto	timer = profiler.start();
+
+		for (uint64_t id = goal; id != NP_NO_PARENT; ) {
+			const Worker		&worker = *workers[id >> 32];
+			const uint32_t		node = id & 0xFFFFFFFFu;
+
+			if (worker.arena[node].getMove() == ROOT)
+				break;
+			result.path.push_front(worker.arena[node].getMove());
+			id = worker.parents[node];
+		}
+		result.path.push_front(ROOT);
+		profiler.stop(PATH_PHASE, timer);
+		profiler.save(result.profile);
+	}
+};
+
+#endif // PARALLEL_A_STAR_HPP
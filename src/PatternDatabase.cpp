@@ -0,0 +1,399 @@
+#include "PatternDatabase.hpp"
+#include "State.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define NP_PDB_MAGIC		"NPUZPDB1"
+#define NP_PDB_UNKNOWN		0xFF
+
+struct Layout {
+	int			mapSize;
+	const char	*name;
+	const char	*regions;	// one letter per place, '.' is the finish place of the empty piece
+};
+
+// regions are given for the normal solution, for other ones '.' swaps with their empty place
+static const Layout	layoutTable[] = {
+	{3, "44",	"AAA"
+				"ABB"
+				"BB."},
+	{4, "78",	"AAAA"
+				"AAAB"
+				"BBBB"
+				"BBB."},
+	{4, "663",	"AABB"
+				"AABB"
+				"AABB"
+				"CCC."},
+	{5, "6666",	"AABBB"
+				"AABBB"
+				"AACDD"
+				"CCCDD"
+				"CCDD."},
+	// pinwheel around the centre, the snail solution keeps a single table for it
+	{5, "6666p",	"AAABB"
+				"AAABB"
+				"CCDBB"
+				"CCDDD"
+				"CCDD."},
+};
+
+static std::map<std::string, std::shared_ptr<const PatternDatabase>>	loaded;
+static std::mutex														loadedMutex;
+
+std::string	PatternDatabase::directory = "pdb";
+
+PatternDatabase::PatternDatabase(int mapSize, const std::vector<int> &tiles)
+	: mapSize(mapSize), mapLength(mapSize * mapSize), tiles(tiles), entries(1),
+	table(nullptr), mapped(nullptr), mappedSize(0)
+{
+	for (int i = 0; i < (int)tiles.size(); i++)
+		entries *= mapLength - i;
+}
+
+// tiles[i] is the turned base->tiles[i], so places of the base pattern are found by turning back
+PatternDatabase::PatternDatabase(const std::shared_ptr<const PatternDatabase> &base,
+								const Symmetry::Transform &transform)
+	: mapSize(base->mapSize), mapLength(base->mapLength), entries(base->entries),
+	table(base->table), mapped(nullptr), mappedSize(0), base(base), inversePlace(transform.inversePlace)
+{
+	for (int tile : base->tiles)
+		tiles.push_back(transform.tile[tile]);
+}
+
+PatternDatabase::~PatternDatabase() {
+	if (mapped != nullptr)
+		munmap(mapped, mappedSize);
+}
+
+// mixed radix number with digits L, L - 1, ..., every digit counts only free places
+size_t	PatternDatabase::rank(const int *places) const {
+	uint64_t	used = 0;
+	size_t		retVal = 0;
+
+	for (int i = 0; i < (int)tiles.size(); i++) {
+		const uint64_t	bit = 1ULL << places[i];
+
+		retVal = retVal * (mapLength - i) + places[i] - __builtin_popcountll(used & (bit - 1));
+		used |= bit;
+	}
+	return (retVal);
+}
+
+void	PatternDatabase::unrank(size_t rank, int *places) const {
+	const int	k = tiles.size();
+	uint64_t	used = 0;
+
+	for (int i = k - 1; i >= 0; i--) {
+		places[i] = rank % (mapLength - i);
+		rank /= mapLength - i;
+	}
+	for (int i = 0; i < k; i++) {
+		int		place = 0;
+
+		for (int free = places[i]; free > 0 || (used >> place) & 1; place++) {
+			if (!((used >> place) & 1))
+				free--;
+		}
+		places[i] = place;
+		used |= 1ULL << place;
+	}
+}
+
+int		PatternDatabase::value(const int *tilePlaces) const {
+	int		places[tiles.size()];
+
+	if (base) {
+		for (size_t i = 0; i < tiles.size(); i++)
+			places[i] = inversePlace[tilePlaces[tiles[i]]];
+	}
+	else {
+		for (size_t i = 0; i < tiles.size(); i++)
+			places[i] = tilePlaces[tiles[i]];
+	}
+	return (table[rank(places)]);
+}
+
+/*
+ * Breadth-first search back from the finish state over (placement, empty place).
+ * The empty piece walks over places without pattern tiles for free,
+ * so the whole region around it is expanded at once, and only moves
+ * of pattern tiles make the next level. Levels are kept as bitsets,
+ * which needs 3 * entries * mapLength bits.
+ */
+void	PatternDatabase::generate(const int *finishMap) {
+	const int			k = tiles.size();
+	const size_t		words = (entries * mapLength + 63) / 64;
+	std::vector<uint64_t>	visited(words, 0);
+	std::vector<uint64_t>	current(words, 0);
+	std::vector<uint64_t>	next(words, 0);
+	std::vector<int>	neighbours(mapLength * LAST, -1);
+	int					goal[mapLength];
+	int					owner[mapLength];
+	int					stack[mapLength];
+	int					places[k];
+	bool				pending = true;
+
+	auto	test = [](const std::vector<uint64_t> &bits, uint64_t i) { return ((bits[i >> 6] >> (i & 63)) & 1); };
+	auto	set = [](std::vector<uint64_t> &bits, uint64_t i) { bits[i >> 6] |= 1ULL << (i & 63); };
+	auto	reset = [](std::vector<uint64_t> &bits, uint64_t i) { bits[i >> 6] &= ~(1ULL << (i & 63)); };
+
+	for (int i = 0; i < mapLength; i++) {
+		goal[finishMap[i]] = i;
+		if (i >= mapSize)
+			neighbours[i * LAST + UP] = i - mapSize;
+		if (i + mapSize < mapLength)
+			neighbours[i * LAST + DOWN] = i + mapSize;
+		if (i % mapSize > 0)
+			neighbours[i * LAST + LEFT] = i - 1;
+		if (i % mapSize + 1 < mapSize)
+			neighbours[i * LAST + RIGHT] = i + 1;
+	}
+	for (int i = 0; i < k; i++)
+		places[i] = goal[tiles[i]];
+
+	data.assign(entries, NP_PDB_UNKNOWN);
+	table = data.data();
+	set(current, (uint64_t)rank(places) * mapLength + goal[0]);
+
+	for (int depth = 0; pending; depth++) {
+		pending = false;
+		for (size_t w = 0; w < words; w++) {
+			while (current[w]) {
+				const uint64_t	state = w * 64 + __builtin_ctzll(current[w]);
+				const size_t	r = state / mapLength;
+				uint64_t		region = 1ULL << (state % mapLength);
+				int				top = 0;
+
+				unrank(r, places);
+				std::fill(owner, owner + mapLength, -1);
+				for (int i = 0; i < k; i++)
+					owner[places[i]] = i;
+				if (data[r] == NP_PDB_UNKNOWN)
+					data[r] = depth;
+
+				stack[top++] = state % mapLength;
+				while (top > 0) {
+					const int		empty = stack[--top];
+					const uint64_t	emptyState = (uint64_t)r * mapLength + empty;
+
+					set(visited, emptyState);
+					reset(current, emptyState);
+					reset(next, emptyState);
+					for (int move = UP; move < LAST; move++) {
+						const int	n = neighbours[empty * LAST + move];
+
+						if (n < 0)
+							continue;
+						if (owner[n] < 0) {
+							if (!((region >> n) & 1)) {
+								region |= 1ULL << n;
+								stack[top++] = n;
+							}
+							continue;
+						}
+						// pattern tile moves to 'empty', the empty piece goes to 'n'
+						places[owner[n]] = empty;
+						const uint64_t	child = (uint64_t)rank(places) * mapLength + n;
+						places[owner[n]] = n;
+						if (!test(visited, child)) {
+							set(next, child);
+							pending = true;
+						}
+					}
+				}
+			}
+		}
+		// every bit of current was reset by the scan
+		current.swap(next);
+	}
+}
+
+void	PatternDatabase::save(const std::string &path, int solutionType) const {
+	Header			header;
+	std::ofstream	file(path, std::ios::binary | std::ios::trunc);
+
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, NP_PDB_MAGIC, sizeof(header.magic));
+	header.mapSize = mapSize;
+	header.solutionType = solutionType;
+	header.tilesCount = tiles.size();
+	std::copy(tiles.begin(), tiles.end(), header.tiles);
+	header.entries = entries;
+
+	file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char *>(table), entries);
+	if (!file.good())
+		throw NP_WriteError();
+}
+
+bool	PatternDatabase::load(const std::string &path, int solutionType) {
+	struct stat	st;
+	const int	fd = open(path.c_str(), O_RDONLY);
+	void		*ptr;
+
+	if (fd < 0)
+		return (false);
+	if (fstat(fd, &st) != 0 || (size_t)st.st_size != sizeof(Header) + entries) {
+		close(fd);
+		return (false);
+	}
+	ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (ptr == MAP_FAILED)
+		return (false);
+
+	const Header	*header = static_cast<const Header *>(ptr);
+	if (std::memcmp(header->magic, NP_PDB_MAGIC, sizeof(header->magic)) != 0 ||
+		header->mapSize != (uint32_t)mapSize || header->solutionType != (uint32_t)solutionType ||
+		header->tilesCount != tiles.size() || header->entries != entries ||
+		!std::equal(tiles.begin(), tiles.end(), header->tiles)) {
+		munmap(ptr, st.st_size);
+		return (false);
+	}
+
+	mapped = ptr;
+	mappedSize = st.st_size;
+	table = static_cast<const uint8_t *>(ptr) + sizeof(Header);
+	data.clear();
+	return (true);
+}
+
+std::vector<std::string>	PatternDatabase::layouts(int mapSize) {
+	std::vector<std::string>	retVal;
+
+	for (auto const &layout : layoutTable)
+		if (layout.mapSize == mapSize)
+			retVal.push_back(layout.name);
+	return (retVal);
+}
+
+std::vector<std::vector<int>>	PatternDatabase::partition(const int *finishMap, int mapSize,
+															const std::string &layout) {
+	const int					mapLength = mapSize * mapSize;
+	std::vector<std::vector<int>>	groups;
+
+	for (auto const &item : layoutTable) {
+		if (item.mapSize != mapSize || layout != item.name)
+			continue;
+
+		const int	dot = std::strchr(item.regions, '.') - item.regions;
+		const int	blank = std::find(finishMap, finishMap + mapLength, 0) - finishMap;
+
+		for (int i = 0; i < mapLength; i++) {
+			if (i == blank)
+				continue;
+
+			const size_t	group = (i == dot ? item.regions[blank] : item.regions[i]) - 'A';
+			if (group >= groups.size())
+				groups.resize(group + 1);
+			groups[group].push_back(finishMap[i]);
+		}
+		for (auto &group : groups)
+			std::sort(group.begin(), group.end());
+		return (groups);
+	}
+	throw NP_InvalidLayout();
+}
+
+std::string	PatternDatabase::fileName(int mapSize, int solutionType, const std::string &layout,
+										size_t index) {
+	return (directory + "/" + std::to_string(mapSize) +
+			(solutionType == SNAIL_SOLUTION ? "_snail_" : "_normal_") +
+			layout + "_" + std::to_string(index) + ".pdb");
+}
+
+int		PatternDatabase::mirrorOf(const Symmetry &symmetry, const std::vector<std::vector<int>> &groups,
+								size_t index, size_t &transform) {
+	// the first group of an orbit is found first, so it's never a mirror itself
+	for (size_t i = 0; i < index; i++) {
+		if (groups[i].size() != groups[index].size())
+			continue;
+		for (transform = 1; transform < symmetry.size(); transform++) {
+			std::vector<int>	turned;
+
+			for (int tile : groups[i])
+				turned.push_back(symmetry[transform].tile[tile]);
+			std::sort(turned.begin(), turned.end());
+			if (turned == groups[index])
+				return (i);
+		}
+	}
+	return (-1);
+}
+
+std::vector<std::shared_ptr<const PatternDatabase>>
+PatternDatabase::get(const int *finishMap, int mapSize, int solutionType) {
+	std::lock_guard<std::mutex>	lock(loadedMutex);
+	const std::vector<std::string>	names = layouts(mapSize);
+	const Symmetry					symmetry(mapSize, solutionType);
+
+	if (names.empty())
+		throw NP_InvalidLayout();
+
+	// the strongest layout which has every table on disk
+	for (auto const &name : names) {
+		const std::vector<std::vector<int>>	groups = partition(finishMap, mapSize, name);
+		std::vector<std::shared_ptr<const PatternDatabase>>	retVal;
+
+		for (size_t i = 0; i < groups.size(); i++) {
+			const std::string	path = fileName(mapSize, solutionType, name, i);
+			auto				it = loaded.find(path);
+			size_t				transform;
+			const int			mirror = mirrorOf(symmetry, groups, i, transform);
+
+			if (mirror >= 0) {
+				retVal.push_back(std::make_shared<const PatternDatabase>(retVal[mirror], symmetry[transform]));
+				continue;
+			}
+			if (it == loaded.end()) {
+				std::shared_ptr<PatternDatabase>	pdb(new PatternDatabase(mapSize, groups[i]));
+
+				if (!pdb->load(path, solutionType))
+					break;
+				it = loaded.insert(std::make_pair(path, pdb)).first;
+			}
+			retVal.push_back(it->second);
+		}
+		if (retVal.size() == groups.size())
+			return (retVal);
+	}
+	throw NP_PatternDatabaseNotFound();
+}
+
+size_t	PatternDatabase::preload() {
+	std::lock_guard<std::mutex>	lock(loadedMutex);
+	const int		solutionTypes[] = {SNAIL_SOLUTION, NORMAL_SOLUTION};
+	size_t			count = 0;
+
+	for (auto const &layout : layoutTable) {
+		for (int solutionType : solutionTypes) {
+			int		finishMap[layout.mapSize * layout.mapSize];
+
+			State<NP_Board64>::makeFinishMap(solutionType, layout.mapSize, finishMap);
+			const std::vector<std::vector<int>>	groups = partition(finishMap, layout.mapSize, layout.name);
+			const Symmetry						symmetry(layout.mapSize, solutionType);
+
+			for (size_t i = 0; i < groups.size(); i++) {
+				const std::string	path = fileName(layout.mapSize, solutionType, layout.name, i);
+				std::shared_ptr<PatternDatabase>	pdb(new PatternDatabase(layout.mapSize, groups[i]));
+				size_t				transform;
+
+				if (mirrorOf(symmetry, groups, i, transform) < 0 && loaded.count(path) == 0 &&
+					pdb->load(path, solutionType)) {
+					loaded.insert(std::make_pair(path, pdb));
+					count++;
+				}
+			}
+		}
+	}
+	return (count);
+}
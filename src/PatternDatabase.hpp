@@ -0,0 +1,99 @@
+#ifndef PATTERN_DATABASE_HPP
+#define PATTERN_DATABASE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Symmetry.hpp"
+
+/*
+ * Additive disjoint pattern database.
+ * Every pattern keeps the exact amount of moves of its own tiles needed to put them
+ * on their finish places, for every placement of these tiles. Moves of other tiles
+ * cost nothing, so values of disjoint patterns can be summed.
+ * Placement of k tiles on L cells is ranked into [0, L! / (L - k)!).
+ */
+class PatternDatabase
+{
+	struct Header {
+		char		magic[8];
+		uint32_t	mapSize;
+		uint32_t	solutionType;
+		uint32_t	tilesCount;
+		uint32_t	tiles[32];
+		uint64_t	entries;
+	};
+
+	int						mapSize, mapLength;
+	std::vector<int>		tiles;
+	size_t					entries;
+	std::vector<uint8_t>	data;		// table built in memory
+	const uint8_t			*table;		// either data or mapped file
+	void					*mapped;
+	size_t					mappedSize;
+	// mirror of a pattern turned by a symmetry of the finish state uses its table
+	std::shared_ptr<const PatternDatabase>	base;
+	std::vector<int>		inversePlace;
+
+	//disable copy constructor;
+	PatternDatabase(const PatternDatabase &rhs);
+	PatternDatabase	&operator=(const PatternDatabase &rhs);
+
+	void	unrank(size_t rank, int *places) const;
+
+public:
+	PatternDatabase(int mapSize, const std::vector<int> &tiles);
+	PatternDatabase(const std::shared_ptr<const PatternDatabase> &base, const Symmetry::Transform &transform);
+	~PatternDatabase();
+
+	// ranks places of pattern tiles, places[i] is a place of tiles[i]
+	size_t	rank(const int *places) const;
+	// tilePlaces is indexed by tile value
+	int		value(const int *tilePlaces) const;
+
+	const std::vector<int>	&getTiles() const { return (tiles); }
+	size_t					getEntries() const { return (entries); }
+
+	void	generate(const int *finishMap);
+	void	save(const std::string &path, int solutionType) const;
+	bool	load(const std::string &path, int solutionType);
+
+	/*
+	 * Layouts split the board into regions, one region per pattern:
+	 * tiles whose finish places are inside a region belong to its pattern.
+	 * Layouts of one size are listed from the strongest to the cheapest one.
+	 */
+	static std::vector<std::string>	layouts(int mapSize);
+	static std::vector<std::vector<int>>	partition(const int *finishMap, int mapSize,
+													const std::string &layout);
+	static std::string	fileName(int mapSize, int solutionType, const std::string &layout, size_t index);
+	// earlier group which turns into groups[index], -1 if none, such group has no file
+	static int			mirrorOf(const Symmetry &symmetry, const std::vector<std::vector<int>> &groups,
+								size_t index, size_t &transform);
+
+	// tables are mapped once and shared by every solve of the process
+	static std::string	directory;
+	static std::vector<std::shared_ptr<const PatternDatabase>>
+						get(const int *finishMap, int mapSize, int solutionType);
+	static size_t		preload();
+
+	class	NP_PatternDatabaseNotFound : public std::exception {
+	public:
+		virtual const char	*what() const throw() {return ("Pattern database not found, generate it with npuzzle_pdb_gen");};
+	};
+
+	class	NP_InvalidLayout : public std::exception {
+	public:
+		virtual const char	*what() const throw() {return ("No pattern database layout for this map size");};
+	};
+
+	class	NP_WriteError : public std::exception {
+	public:
+		virtual const char	*what() const throw() {return ("Can't write pattern database");};
+	};
+};
+
+#endif // PATTERN_DATABASE_HPP
@@ -0,0 +1,80 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+
+enum profilePhases {
+	VALIDATION_PHASE,	// arguments of the solve and isSolvable
+	SETUP_PHASE,		// context, heuristic tables, pattern databases
+	EXPANSION_PHASE,	// search loop without the phases below
+	HEURISTIC_PHASE,	// creation of children, heuristic is updated there
+	OPEN_LIST_PHASE,
+	CLOSED_SET_PHASE,	// table of known boards
+	PATH_PHASE,			// reconstruction of the path
+	PHASES
+};
+
+// time and calls of every phase of a solve, filled only when profiling is on
+class NP_profile {
+public:
+	bool	enabled;
+	double	time[PHASES];	// seconds, threads of parallel A* are summed
+	size_t	calls[PHASES];
+
+	NP_profile() : enabled(false), time(), calls() {};
+
+	static const char	*name(int phase) {
+		static const char	*names[PHASES] = {"validation", "setup", "expansion", "heuristic",
+											"openList", "closedSet", "path"};
+		return (names[phase]);
+	}
+};
+
+/*
+ * Timers of one thread of a search. When profiling is off start() and stop()
+ * are a single branch, so searches call them around every operation.
+ */
+class Profiler {
+	typedef std::chrono::steady_clock	clock;
+
+	bool				enabled;
+	clock::duration		time[PHASES];
+	size_t				calls[PHASES];
+
+public:
+	explicit Profiler(bool enabled = false) : enabled(enabled), time(), calls() {};
+
+	clock::time_point	start() const {
+		return (enabled ? clock::now() : clock::time_point());
+	}
+
+	void	stop(int phase, clock::time_point start, size_t count = 1) {
+		if (enabled) {
+			time[phase] += clock::now() - start;
+			calls[phase] += count;
+		}
+	}
+
+	// adds timers to 'profile', expansion loses the time of phases nested in it
+	void	save(NP_profile &profile) const {
+		if (!enabled)
+			return ;
+
+		clock::duration	nested = clock::duration::zero();
+
+		for (int phase = HEURISTIC_PHASE; phase < PHASES; phase++)
+			nested += time[phase];
+		for (int phase = 0; phase < PHASES; phase++) {
+			clock::duration	own = time[phase];
+
+			if (phase == EXPANSION_PHASE && own != clock::duration::zero())
+				own = std::max(own - nested, clock::duration::zero());
+			profile.time[phase] += std::chrono::duration<double>(own).count();
+			profile.calls[phase] += calls[phase];
+		}
+	}
+};
+
+#endif // PROFILER_HPP
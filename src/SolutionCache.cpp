@@ -0,0 +1,187 @@
+#include "SolutionCache.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#define NP_CACHE_MAGIC		"NPUZSOL1"
+
+/*
+ * Snapshot: magic, amount of entries, then for every entry lengths of its key
+ * and path and their bytes. Entries go from the least recently used one,
+ * so loading them one by one restores the order.
+ */
+struct SnapshotHeader {
+	char		magic[8];
+	uint64_t	entries;
+};
+
+struct SnapshotEntry {
+	uint32_t	keyLength;
+	uint32_t	pathLength;
+};
+
+SolutionCache::SolutionCache(size_t capacity)
+	: capacity(capacity), used(0), hits(0), misses(0), dirty(false) {
+}
+
+// strings, node of the list and node of the index
+size_t	SolutionCache::entrySize(const Entry &entry) {
+	return (entry.key.size() + entry.path.size() + sizeof(Entry) + 2 * sizeof(void *) +
+			sizeof(std::pair<std::string, Entries::iterator>) + 2 * sizeof(void *));
+}
+
+std::string	SolutionCache::makeKey(const int *map, int mapLength, int solutionType, int heuristic,
+									int optimisation, int algorithm, int weight) {
+	std::string	key;
+
+	auto	push = [&key](int value) {
+		if (value < 0 || value > 0xFF)
+			return (false);
+		key.push_back((char)value);
+		return (true);
+	};
+
+	// a byte per value, wrong values can't be cached, so they can't be mixed up with right ones
+	key.reserve(mapLength + 5);
+	if (!push(solutionType) || !push(heuristic) || !push(optimisation) || !push(algorithm) || !push(weight))
+		return ("");
+	for (int i = 0; i < mapLength; i++)
+		if (!push(map[i]))
+			return ("");
+	return (key);
+}
+
+// mutex is locked
+void	SolutionCache::add(const std::string &key, const std::string &path) {
+	auto	it = index.find(key);
+
+	if (it != index.end()) {
+		used -= entrySize(*it->second);
+		entries.erase(it->second);
+		index.erase(it);
+	}
+	entries.push_front(Entry{key, path});
+	index[key] = entries.begin();
+	used += entrySize(entries.front());
+
+	while (used > capacity && !entries.empty()) {
+		used -= entrySize(entries.back());
+		index.erase(entries.back().key);
+		entries.pop_back();
+	}
+	dirty = true;
+}
+
+bool	SolutionCache::find(const std::string &key, std::list<int> &path) {
+	std::lock_guard<std::mutex>	lock(mutex);
+	auto						it = index.find(key);
+
+	if (it == index.end()) {
+		misses++;
+		return (false);
+	}
+	hits++;
+	entries.splice(entries.begin(), entries, it->second);
+	path.assign(it->second->path.begin(), it->second->path.end());
+	return (true);
+}
+
+void	SolutionCache::insert(const std::string &key, const std::list<int> &path) {
+	std::lock_guard<std::mutex>	lock(mutex);
+
+	add(key, std::string(path.begin(), path.end()));
+}
+
+size_t	SolutionCache::usedMemory() const {
+	std::lock_guard<std::mutex>	lock(mutex);
+
+	return (used);
+}
+
+size_t	SolutionCache::size() const {
+	std::lock_guard<std::mutex>	lock(mutex);
+
+	return (entries.size());
+}
+
+size_t	SolutionCache::getHits() const {
+	std::lock_guard<std::mutex>	lock(mutex);
+
+	return (hits);
+}
+
+size_t	SolutionCache::getMisses() const {
+	std::lock_guard<std::mutex>	lock(mutex);
+
+	return (misses);
+}
+
+void	SolutionCache::save(const std::string &path) {
+	std::vector<char>	data;
+
+	{
+		// the cache is blocked only while it's copied, the file is written without the lock
+		std::lock_guard<std::mutex>	lock(mutex);
+		SnapshotHeader				header;
+
+		if (!dirty)
+			return ;
+		std::memset(&header, 0, sizeof(header));
+		std::memcpy(header.magic, NP_CACHE_MAGIC, sizeof(header.magic));
+		header.entries = entries.size();
+		data.insert(data.end(), (const char *)&header, (const char *)(&header + 1));
+		for (auto it = entries.rbegin(); it != entries.rend(); it++) {
+			const SnapshotEntry	entry = {(uint32_t)it->key.size(), (uint32_t)it->path.size()};
+
+			data.insert(data.end(), (const char *)&entry, (const char *)(&entry + 1));
+			data.insert(data.end(), it->key.begin(), it->key.end());
+			data.insert(data.end(), it->path.begin(), it->path.end());
+		}
+		dirty = false;
+	}
+
+	// readers never see a half written snapshot
+	const std::string	temporary = path + ".tmp";
+	std::ofstream		file(temporary, std::ios::binary | std::ios::trunc);
+
+	file.write(data.data(), data.size());
+	file.close();
+	if (!file.good() || std::rename(temporary.c_str(), path.c_str()) != 0) {
+		std::lock_guard<std::mutex>	lock(mutex);
+
+		dirty = true;
+		throw NP_WriteError();
+	}
+}
+
+bool	SolutionCache::load(const std::string &path) {
+	std::ifstream	file(path, std::ios::binary);
+	SnapshotHeader	header;
+
+	if (!file.read((char *)&header, sizeof(header)) ||
+		std::memcmp(header.magic, NP_CACHE_MAGIC, sizeof(header.magic)) != 0)
+		return (false);
+
+	std::lock_guard<std::mutex>	lock(mutex);
+
+	for (uint64_t i = 0; i < header.entries; i++) {
+		SnapshotEntry	entry;
+
+		// map has less than 256 tiles, longer entries mean a broken file
+		if (!file.read((char *)&entry, sizeof(entry)) || entry.keyLength > 260 || entry.pathLength > (1 << 24))
+			return (false);
+
+		std::string		key(entry.keyLength, '\0');
+		std::string		moves(entry.pathLength, '\0');
+
+		if (!file.read(&key[0], key.size()) || !file.read(&moves[0], moves.size()))
+			return (false);
+		add(key, moves);
+	}
+	// the file has the same entries
+	dirty = false;
+	return (true);
+}
@@ -0,0 +1,71 @@
+#ifndef SOLUTION_CACHE_HPP
+#define SOLUTION_CACHE_HPP
+
+#include <cstddef>
+#include <exception>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/*
+ * LRU cache of solved puzzles, bounded by bytes.
+ * Key is a board with everything the solve depends on: solution type, heuristic,
+ * optimisation, algorithm and weight, so the answer is the one a new solve would give.
+ * Server keys canonical boards (see Symmetry), so a symmetric board may give
+ * the answer, it has the same length for optimal solves.
+ * Cache is shared by every thread of the server.
+ */
+class SolutionCache
+{
+	struct Entry {
+		std::string	key;
+		std::string	path;	// a byte per move
+	};
+
+	typedef std::list<Entry>	Entries;
+
+	size_t											capacity;	// bytes
+	size_t											used;
+	Entries											entries;	// most recently used first
+	std::unordered_map<std::string, Entries::iterator>	index;
+	size_t											hits;
+	size_t											misses;
+	bool											dirty;		// changed since the last save
+	mutable std::mutex								mutex;
+
+	//disable copy constructor;
+	SolutionCache(const SolutionCache &rhs);
+	SolutionCache	&operator=(const SolutionCache &rhs);
+
+	static size_t	entrySize(const Entry &entry);
+	void			add(const std::string &key, const std::string &path);
+
+public:
+	explicit SolutionCache(size_t capacity);
+	~SolutionCache() {};
+
+	// empty key if some value doesn't fit into a byte, such task isn't cached
+	static std::string	makeKey(const int *map, int mapLength, int solutionType, int heuristic,
+								int optimisation, int algorithm, int weight);
+
+	bool	find(const std::string &key, std::list<int> &path);
+	void	insert(const std::string &key, const std::list<int> &path);
+
+	size_t	getCapacity() const { return (capacity); }
+	size_t	usedMemory() const;
+	size_t	size() const;
+	size_t	getHits() const;
+	size_t	getMisses() const;
+
+	// snapshot is written only if the cache was changed, false if there is nothing to load
+	void	save(const std::string &path);
+	bool	load(const std::string &path);
+
+	class	NP_WriteError : public std::exception {
+	public:
+		virtual const char	*what() const throw() {return ("Can't write snapshot of solution cache");};
+	};
+};
+
+#endif // SOLUTION_CACHE_HPP
@@ -0,0 +1,79 @@
+#ifndef SOLVER_CONTEXT_HPP
+#define SOLVER_CONTEXT_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "Budget.hpp"
+#include "State.hpp"
+#include "Heuristic.hpp"
+
+/*
+ * Everything one solve needs besides its nodes: geometry of the map,
+ * heuristic tables and functions, ordering of the open list, budget, profiling.
+ * Every solve owns its context, so puzzles can be solved in parallel.
+ */
+template <typename Board>
+class SolverContext
+{
+	//disable copy constructor;
+	SolverContext(const SolverContext &rhs);
+	SolverContext	&operator=(const SolverContext &rhs);
+
+public:
+	typedef int	(Heuristic::*HeuristicFunc)(const State<Board> *state) const;
+	typedef int	(Heuristic::*HeuristicDelta)(const State<Board> *state, int price, int tile, int from, int to) const;
+
+	const int			mapSize, mapLength;
+	const bool			byPrice;	// optimisation by time
+	int					weight;		// of the price in keys of A*, in 1 / NP_WEIGHT_UNIT
+	std::vector<int>	neighbours;	// [place * LAST + move] -> new place of empty piece or -1
+	std::vector<uint64_t>	zobrist;	// [tile * mapLength + place] -> random key of Zobrist hash
+	Heuristic			heuristic;
+	HeuristicFunc		heuristicFunc;
+	HeuristicDelta		heuristicDelta;
+	BudgetWatch			budget;
+	bool				profiling;
+
+	SolverContext(int mapLength, bool byPrice)
+		: mapSize((int)std::sqrt(mapLength)), mapLength(mapLength), byPrice(byPrice), weight(NP_WEIGHT_UNIT),
+		neighbours(mapLength * LAST, -1), zobrist(mapLength * mapLength, 0),
+		heuristicFunc(nullptr), heuristicDelta(nullptr), profiling(false)
+	{
+		// fixed seed, so boards of one size have the same hash in every solve
+		uint64_t	seed = 0x4E50757A7A6C6521ULL;
+
+		// empty piece has no keys, its place follows from places of tiles
+		for (size_t i = mapLength; i < zobrist.size(); i++) {
+			uint64_t	z = (seed += 0x9E3779B97F4A7C15ULL);
+
+			// splitmix64
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+			zobrist[i] = z ^ (z >> 31);
+		}
+		for (int i = 0; i < mapLength; i++) {
+			const int	x = i % mapSize;
+			const int	y = i / mapSize;
+			int			*moves = &neighbours[i * LAST];
+
+			moves[ROOT] = i;
+			if (y > 0)
+				moves[UP] = i - mapSize;
+			if (y + 1 < mapSize)
+				moves[DOWN] = i + mapSize;
+			if (x > 0)
+				moves[LEFT] = i - 1;
+			if (x + 1 < mapSize)
+				moves[RIGHT] = i + 1;
+		}
+	}
+
+	uint64_t	key(int tile, int place) const { return (zobrist[tile * mapLength + place]); }
+	int		price(const State<Board> *state) const { return ((heuristic.*heuristicFunc)(state)); }
+	int		delta(const State<Board> *state, int price, int tile, int from, int to) const {
+		return ((heuristic.*heuristicDelta)(state, price, tile, from, to));
+	}
+};
+
+#endif // SOLVER_CONTEXT_HPP
@@ -1,56 +1,70 @@
 #include "State.hpp"
+#include "SolverContext.hpp"
 
+#include <cassert>
 #include <cstdio>
 #include <algorithm>
 #include <cmath>
 #include <iomanip>
-#include <boost/functional/hash.hpp>
-#include "main.hpp"
 
-State	*State::finishState = nullptr;
-int		(*State::heuristicFunc)(const State *state) = nullptr;
-int		State::mapSize = 0, State::mapLength = 0;
-
-auto findIndexInMap = [](int value, const int *map, const int mapLength) {
+template <typename Board>
+static int	findIndexInBoard(int value, const Board &board, const int mapLength) {
 	for (int i = 0; i < mapLength; i++)
-		if (map[i] == value)
+		if (board.get(i) == value)
 			return (i);
 	return (-1);
-};
+}
 
-State::State(const int *map) {
-	if (finishState == nullptr || State::heuristicFunc == nullptr ||
-		mapSize == 0 || mapLength == 0) {
-		throw (NP_StaticVarsUnset());
-	}
+template <typename Board>
+State<Board>::State(const Context &ctx, const int *map) {
+	if (ctx.heuristicFunc == nullptr || ctx.heuristicDelta == nullptr)
+		throw (NP_ContextUnset());
 
-	this->map.resize(State::mapLength);
-	for (int i = 0; i < State::mapLength; i++)
-		this->map[i] = map[i];
+	this->board.pack(map, ctx.mapLength);
+	this->blank = findIndexInBoard(0, this->board, ctx.mapLength);
+	this->hash = 0;
+	for (int i = 0; i < ctx.mapLength; i++)
+		if (map[i] != 0)
+			this->hash ^= ctx.key(map[i], i);
 
-	this->price = State::heuristicFunc(this);
+	this->price = ctx.price(this);
 	this->length = 0;
-	this->cost = price;
 	this->movement = ROOT;
-	this->prev = nullptr;
+	this->prev = NP_NO_NODE;
+}
+
+template <typename Board>
+State<Board>::State(const Board &board, uint64_t hash, int blank, int price, int length, int move)
+	: price(price), length(length), prev(NP_NO_NODE), movement(move), blank(blank),
+	hash(hash), board(board) {
 }
 
-void	State::makeSnailState() {
+template <typename Board>
+void	State<Board>::makeFinishMap(int solutionType, int mapSize, int *map) {
+	const int	mapLength = mapSize * mapSize;
+
+	if (solutionType != SNAIL_SOLUTION) {
+		for (int i = 0; i < mapLength - 1; i++)
+			map[i] = i + 1;
+		map[mapLength - 1] = 0;
+		return ;
+	}
+
 	int	row = 0;
 	int	col = 0;
 	int	dx = 1;
 	int	dy = 0;
-	int matr[State::mapSize][State::mapSize];
+	int matr[mapSize][mapSize];
 
 	std::fill(&matr[0][0], &matr[0][0] + (sizeof(matr) / sizeof(matr[0][0])), -1);
-	for (int i = 0; i < State::mapLength; i++) {
+	for (int i = 0; i < mapLength; i++) {
 		matr[row][col] = i + 1;
-		if (i + 1 == State::mapLength)
+		if (i + 1 == mapLength)
 			matr[row][col] = 0;
 
-		if ((col + dx == State::mapSize || col + dx < 0 ||
+		if ((col + dx == mapSize || col + dx < 0 ||
 			(dx != 0 && matr[row][col + dx] != -1)) ||
-			(row + dy == State::mapSize || row + dy < 0 ||
+			(row + dy == mapSize || row + dy < 0 ||
 			(dy != 0 && matr[row + dy][col] != -1)))
 		{
 			std::swap(dx, dy);
@@ -61,136 +75,139 @@ void	State::makeSnailState() {
 		row += dy;
 	}
 
-	this->map.resize(State::mapLength);
 	int m = 0;
-	for (int i = 0; i < State::mapSize; i++)
-		for (int j = 0; j < State::mapSize; j++)
-			this->map[m++] = matr[i][j];
+	for (int i = 0; i < mapSize; i++)
+		for (int j = 0; j < mapSize; j++)
+			map[m++] = matr[i][j];
 }
 
-void	State::makeNormalState() {
-	this->map.resize(State::mapLength);
-	for (int i = 0; i < State::mapLength; i++)
-		this->map[i] = i + 1;
-	this->map[State::mapLength - 1] = 0;
-}
+template <typename Board>
+const int	State<Board>::oppositeMove[LAST] = {ROOT, DOWN, UP, RIGHT, LEFT};
 
-State::State(const int solutionType) {
-	if (mapSize == 0 || mapLength == 0) {
-		throw (NP_StaticVarsUnset());
-	}
+template <typename Board>
+void	State<Board>::unpack(const Context &ctx, int *map) const {
+	this->board.unpack(map, ctx.mapLength);
+}
 
-	if (solutionType == SNAIL_SOLUTION)
-		makeSnailState();
-	else
-		makeNormalState();
-	this->price = 0;
-	this->cost = 0;
-	this->length = 0;
-	this->movement = 0;
-	this->prev = nullptr;
-	this->movement = ROOT;
+template <typename Board>
+bool	State<Board>::canMove(const Context &ctx, int move) const {
+	if (move < ROOT || move >= LAST)
+		return (false);
+	return (ctx.neighbours[this->blank * LAST + move] >= 0);
 }
 
-State::State(const State &src, const int move)
-{
-	const int	*map = src.getMapPtr();
-	int			x, y, newPos, zeroIndex;
+// legal moves of the empty piece, except the one which returns to the parent
+template <typename Board>
+int		State<Board>::getMoves(const Context &ctx, int *moves) const {
+	const int	*places = &ctx.neighbours[this->blank * LAST];
+	const int	back = State::oppositeMove[this->movement];
+	int			count = 0;
 
-	if (finishState == nullptr || State::heuristicFunc == nullptr ||
-		mapSize == 0 || mapLength == 0) {
-		throw (NP_StaticVarsUnset());
+	for (int move = UP; move < LAST; move++) {
+		if (places[move] >= 0 && move != back)
+			moves[count++] = move;
 	}
+	return (count);
+}
 
-	zeroIndex = findIndexInMap(0, map, State::mapLength);
-
-	x = zeroIndex % State::mapSize;
-	y = zeroIndex / State::mapSize;
-
-	switch (move) {
-		case UP:
-			if (y - 1 < 0)
-				throw NP_InvalidMove();
-			newPos = x + ((y - 1) * State::mapSize);
-			break;
-		case DOWN:
-			if (y + 1 == State::mapSize)
-				throw NP_InvalidMove();
-			newPos = x + ((y + 1) * State::mapSize);
-			break;
-		case LEFT:
-			if (x - 1 < 0)
-				throw NP_InvalidMove();
-			newPos = (x - 1) + (y * State::mapSize);
-			break;
-		case RIGHT:
-			if (x + 1 == State::mapSize)
-				throw NP_InvalidMove();
-			newPos = (x + 1) + (y * State::mapSize);
-			break;
-		case ROOT: // just make a copy
-			newPos = zeroIndex;
-			break;
-		default:
-			throw NP_InvalidMove();
-			break;
-	}
+template <typename Board>
+void	State<Board>::doMove(const Context &ctx, int move) {
+	const int	to = this->blank;
+	const int	from = ctx.neighbours[to * LAST + move];
+	const int	tile = this->board.get(from);
+
+	this->board.set(to, tile);
+	this->board.set(from, 0);
+	this->blank = from;
+	this->hash ^= ctx.key(tile, from) ^ ctx.key(tile, to);
+	this->price = ctx.delta(this, this->price, tile, from, to);
+#ifdef NP_CHECK_HEURISTIC
+	assert(this->price == ctx.price(this));
+#endif
+	this->length++;
+	this->movement = move;
+}
 
-	this->map.resize(State::mapLength);
-	for (int i = 0; i < State::mapLength; i++)
-		this->map[i] = map[i];
-	this->swapPieces(zeroIndex, newPos);
+template <typename Board>
+void	State<Board>::undoMove(const Context &ctx, int move, int parentMove, int parentPrice) {
+	const int	to = this->blank;
+	const int	from = ctx.neighbours[to * LAST + State::oppositeMove[move]];
+	const int	tile = this->board.get(from);
+
+	this->board.set(to, tile);
+	this->board.set(from, 0);
+	this->blank = from;
+	this->hash ^= ctx.key(tile, from) ^ ctx.key(tile, to);
+	this->price = parentPrice;
+	this->length--;
+	this->movement = parentMove;
+}
 
-	this->price = State::heuristicFunc(this);
+template <typename Board>
+State<Board>::State(const Context &ctx, const State &src, const int move, const uint32_t parent)
+{
+	int			newPos, zeroIndex, tile;
+
+	if (ctx.heuristicFunc == nullptr || ctx.heuristicDelta == nullptr)
+		throw (NP_ContextUnset());
+
+	// ROOT just makes a copy
+	if (move < ROOT || move >= LAST)
+		throw NP_InvalidMove();
+	zeroIndex = src.blank;
+	if ((newPos = ctx.neighbours[zeroIndex * LAST + move]) < 0)
+		throw NP_InvalidMove();
+
+	this->board = src.board;
+	this->board.swap(zeroIndex, newPos);
+	this->blank = newPos;
+	tile = this->board.get(zeroIndex);
+
+	// only one tile was moved, so update parent's price and hash instead of full recount
+	if (move == ROOT) {
+		this->price = src.price;
+		this->hash = src.hash;
+	}
+	else {
+		this->price = ctx.delta(this, src.price, tile, newPos, zeroIndex);
+		this->hash = src.hash ^ ctx.key(tile, newPos) ^ ctx.key(tile, zeroIndex);
+	}
+#ifdef NP_CHECK_HEURISTIC
+	assert(this->price == ctx.price(this));
+#endif
 	this->length = src.getLength() + 1;
-	this->cost = this->price + this->length;
 	this->movement = move;
-	this->prev = &src;
+	this->prev = parent;
 }
 
-void	State::printState() const {
-	printf("State price = %d, length = %d, mapSize = %d\n", this->price, this->length, State::mapSize);
-	for (int i = 0; i < State::mapLength; i++) {
-		if (i % State::mapSize == 0)
+template <typename Board>
+void	State<Board>::printState(const Context &ctx) const {
+	printf("State price = %d, length = %d, mapSize = %d\n", this->price, this->length, ctx.mapSize);
+	for (int i = 0; i < ctx.mapLength; i++) {
+		if (i % ctx.mapSize == 0)
 			std::cout << std::endl;
 
-		if (this->map[i])
-			std::cout << std::setw(2) << this->map[i] << " ";
+		if (this->board.get(i))
+			std::cout << std::setw(2) << this->board.get(i) << " ";
 		else
 			std::cout << std::setw(2) << "__ ";
 	}
 	std::cout << std::endl << std::endl;
 }
 
-size_t HashState::operator()(const std::shared_ptr<State> &a) const {
-	const int	*map = a->getMapPtr();
-	const int	mapLength = a->getMapLength();
+template <typename Board>
+bool CompareState<Board>::operator()(uint32_t lhs, uint32_t rhs) const {
+	const State<Board>	&a = (*arena)[lhs];
+	const State<Board>	&b = (*arena)[rhs];
+	const size_t		keyA = key(a);
+	const size_t		keyB = key(b);
 
-	return boost::hash_range(map, map + mapLength);
+	if (keyA == keyB)
+		return a.getLength() > b.getLength();
+	return keyA > keyB;
 }
 
-bool CompareState::operator()(const std::shared_ptr<State> &a, const std::shared_ptr<State> &b) {
-	// optimisation by time
-	if (optimisationByTime) {
-		if (a->getPrice() == b->getPrice())
-			return a->getLength() > b->getLength();
-		return a->getPrice() > b->getPrice();
-	}
-
-	// optimisation by paths' length
-	if (a->getCost() == b->getCost())
-		return a->getLength() > b->getLength();
-	return a->getCost() > b->getCost();
-}
-
-bool EqualState::operator()(const std::shared_ptr<State> &lhs, const std::shared_ptr<State> &rhs) const {
-	const int *pa = rhs->getMapPtr();
-	const int *pb = lhs->getMapPtr();
-	const int mapLength = lhs->getMapLength();
-
-	for (int i = 0; i < mapLength; i++) {
-		if (pa[i] != pb[i])
-			return (false);
-	}
-	return (true);
-}
+template class	State<NP_Board16>;
+template class	State<NP_Board64>;
+template struct	CompareState<NP_Board16>;
+template struct	CompareState<NP_Board64>;
@@ -5,6 +5,8 @@
 #include <iostream>
 #include <vector>
 #include <memory>
+#include "Board.hpp"
+#include "NodeArena.hpp"
 #include "Heuristic.hpp"
 
 enum moves { ROOT, UP, DOWN, LEFT, RIGHT, LAST };
@@ -16,71 +18,110 @@ enum heuristicFuncs {
 	MANHATTAN_DISTANCE,
 	MISPLACED_TILES_PLUS_LINEAR_CONFLICTS,
 	MANHATTAN_DISTANCE_PLUS_LINEAR_CONFLICTS,
-	N_MAXSWAP
+	N_MAXSWAP,
+	PATTERN_DATABASE
 };
 
+#define NP_WEIGHT_UNIT	10	// weights of the price are integers in tenths
+
+template <typename Board> class SolverContext;
+
+/*
+ * Node of the search. Configuration of the solve isn't stored in nodes,
+ * so everything which needs it takes SolverContext.
+ */
+template <typename Board>
 class State
 {
 private:
-	static State	*finishState;
-	static int		(*heuristicFunc)(const State *state);
-	static int		mapSize, mapLength;
-
-	int		cost;	// price + length
 	int		price;	// value of heuristic func
 	int		length;
-	int		movement;
-	std::vector<int>	map;
-	const State			*prev;
+	uint32_t	prev;	// index of parent in NodeArena
+	uint8_t	movement;
+	uint8_t	blank;	// place of empty piece
+	uint64_t	hash;	// Zobrist hash of the board, updated by every move
+	Board				board;
 
 	//disable copy constructor;
 	State(const State &rhs) {(void)rhs;};
 	State	&operator=(const State &rhs) {(void)rhs; return (*this);};
 
-	void	makeSnailState();
-	void	makeNormalState();
+	static const int	oppositeMove[LAST];
 
 public:
-	State(const int *map);
-	State(const int solutionType); //build finish state
-	State(const State &src, const int move);
-	~State() {};
+	typedef SolverContext<Board>	Context;
+
+	State(const Context &ctx, const int *map);
+	State(const Context &ctx, const State &src, const int move, const uint32_t parent = NP_NO_NODE);
+	// node built by another thread of parallel search, which keeps parents itself
+	State(const Board &board, uint64_t hash, int blank, int price, int length, int move);
+
+	// finish map doesn't depend on the context, so it can be built by tools
+	static void		makeFinishMap(int solutionType, int mapSize, int *map);
 
 	int				getLength() const { return (this->length); }
 	int				getPrice() const { return (this->price); }
-	int				getCost() const { return (this->cost); }
-	const int		*getMapPtr() const { return (this->map.data()); }
-	int				getMapSize() const { return (this->mapSize); }
-	int				getMapLength() const { return (this->mapLength); }
-	void			swapPieces(int a, int b) { std::swap(map[a], map[b]); };
+	// cost isn't stored, so the hash fits into the node without growing it
+	int				getCost() const { return (this->price + this->length); }
+	int				getTile(int i) const { return (this->board.get(i)); }
+	const Board		&getBoard() const { return (this->board); }
+	uint64_t		getHash() const { return (this->hash); }
+	void			unpack(const Context &ctx, int *map) const;
+	int				getBlank() const { return (this->blank); }
+	bool			canMove(const Context &ctx, int move) const;
+	int				getMoves(const Context &ctx, int *moves) const;
+	// in-place moves for depth-first search, move must be legal
+	void			doMove(const Context &ctx, int move);
+	void			undoMove(const Context &ctx, int move, int parentMove, int parentPrice);
 	int				getMove() const { return (this->movement); };
-	const State		*getPrev() const { return (this->prev); };
-	void			printState() const;
+	static int		getOppositeMove(int move) { return (oppositeMove[move]); }
+	uint32_t		getPrev() const { return (this->prev); };
+	void			printState(const Context &ctx) const;
 
 	class	NP_InvalidMove : public std::exception {
 	public:
 		virtual const char	*what() const throw() {return ("Invalid move, can't create state");};
 	};
 
-	class	NP_StaticVarsUnset : public std::exception {
+	class	NP_ContextUnset : public std::exception {
 	public:
-		virtual const char	*what() const throw() {return ("Static variables for class State wasn't setted");};
+		virtual const char	*what() const throw() {return ("Heuristic of solver context wasn't setted");};
 	};
 	friend class	NPuzzleSolver;
 	friend class	Heuristic;
 	friend class	NP_retVal;
 };
 
-struct HashState {
-	size_t operator()(const std::shared_ptr<State> &a) const;
+/*
+ * Key of a node in open lists: lengthFactor * length + priceFactor * price.
+ * Optimisation by time counts only the price, A* the cost, weighted A* the length
+ * and the price multiplied by weight / NP_WEIGHT_UNIT, so keys stay integers.
+ */
+struct NodeKey {
+	int		lengthFactor;
+	int		priceFactor;
+
+	NodeKey(bool byPrice, int weight = NP_WEIGHT_UNIT)
+		: lengthFactor(byPrice ? 0 : (weight == NP_WEIGHT_UNIT ? 1 : NP_WEIGHT_UNIT)),
+		priceFactor(byPrice || weight == NP_WEIGHT_UNIT ? 1 : weight) {};
+
+	template <typename Board>
+	size_t	operator()(const State<Board> &state) const {
+		return (lengthFactor * state.getLength() + priceFactor * state.getPrice());
+	}
 };
 
+/*
+ * Functor for open lists, which keep indexes of nodes in NodeArena
+ */
+template <typename Board>
 struct CompareState {
-	bool operator()(const std::shared_ptr<State> &a, const std::shared_ptr<State> &b);
-};
+	const NodeArena<State<Board>>	*arena;
+	NodeKey							key;
 
-struct EqualState {
-	bool operator()(const std::shared_ptr<State> &lhs, const std::shared_ptr<State> &rhs) const;
+	CompareState(const NodeArena<State<Board>> *arena, bool byPrice, int weight = NP_WEIGHT_UNIT)
+		: arena(arena), key(byPrice, weight) {};
+	bool operator()(uint32_t a, uint32_t b) const;
 };
 
 #endif /* STATE_HPP */
@@ -0,0 +1,95 @@
+#include "Symmetry.hpp"
+
+#include <algorithm>
+
+// turns and reflections of a square with the last row or column 'm'
+static void	turn(int symmetry, int m, int row, int col, int &toRow, int &toCol) {
+	const int	rows[8] = {row, col, m - row, m - col, row, m - row, col, m - col};
+	const int	cols[8] = {col, m - row, m - col, row, m - col, col, row, m - row};
+
+	toRow = rows[symmetry];
+	toCol = cols[symmetry];
+}
+
+Symmetry::Symmetry(int mapSize, int solutionType) : mapLength(mapSize * mapSize) {
+	const int	rowStep[LAST] = {0, -1, 1, 0, 0};
+	const int	colStep[LAST] = {0, 0, 0, -1, 1};
+	std::vector<int>	finishMap(mapLength);
+	std::vector<int>	goal(mapLength);
+	int					blank;
+
+	if (mapLength == 0)
+		return ;
+	State<NP_Board64>::makeFinishMap(solutionType, mapSize, finishMap.data());
+	for (int i = 0; i < mapLength; i++)
+		goal[finishMap[i]] = i;
+	blank = goal[0];
+
+	for (int symmetry = 0; symmetry < 8; symmetry++) {
+		Transform	transform;
+		int			row, col, originRow, originCol;
+
+		turn(symmetry, mapSize - 1, blank / mapSize, blank % mapSize, row, col);
+		if (row * mapSize + col != blank)
+			continue;
+
+		transform.place.resize(mapLength);
+		transform.inversePlace.resize(mapLength);
+		transform.tile.resize(mapLength);
+		for (int i = 0; i < mapLength; i++) {
+			turn(symmetry, mapSize - 1, i / mapSize, i % mapSize, row, col);
+			transform.place[i] = row * mapSize + col;
+			transform.inversePlace[row * mapSize + col] = i;
+		}
+		// tile goes where its finish place goes
+		for (int tile = 0; tile < mapLength; tile++)
+			transform.tile[tile] = finishMap[transform.place[goal[tile]]];
+
+		// moves are turned like steps from the corner
+		turn(symmetry, mapSize - 1, 0, 0, originRow, originCol);
+		transform.move[ROOT] = ROOT;
+		transform.inverseMove[ROOT] = ROOT;
+		for (int move = UP; move < LAST; move++) {
+			turn(symmetry, mapSize - 1, rowStep[move], colStep[move], row, col);
+			for (int to = UP; to < LAST; to++) {
+				if (rowStep[to] == row - originRow && colStep[to] == col - originCol) {
+					transform.move[move] = to;
+					transform.inverseMove[to] = move;
+				}
+			}
+		}
+		transforms.push_back(transform);
+	}
+}
+
+void	Symmetry::apply(size_t transform, const int *map, int *turned) const {
+	const Transform	&t = transforms[transform];
+
+	for (int i = 0; i < mapLength; i++)
+		turned[t.place[i]] = t.tile[map[i]];
+}
+
+size_t	Symmetry::canonical(const int *map, int *canonicalMap) const {
+	int		turned[mapLength];
+	size_t	retVal = 0;
+
+	std::copy(map, map + mapLength, canonicalMap);
+	for (size_t i = 1; i < transforms.size(); i++) {
+		apply(i, map, turned);
+		if (std::lexicographical_compare(turned, turned + mapLength, canonicalMap, canonicalMap + mapLength)) {
+			std::copy(turned, turned + mapLength, canonicalMap);
+			retVal = i;
+		}
+	}
+	return (retVal);
+}
+
+void	Symmetry::turnPath(size_t transform, std::list<int> &path) const {
+	for (auto &move : path)
+		move = transforms[transform].move[move];
+}
+
+void	Symmetry::restorePath(size_t transform, std::list<int> &path) const {
+	for (auto &move : path)
+		move = transforms[transform].inverseMove[move];
+}
@@ -0,0 +1,47 @@
+#ifndef SYMMETRY_HPP
+#define SYMMETRY_HPP
+
+#include <cstddef>
+#include <list>
+#include <vector>
+#include "State.hpp"
+
+/*
+ * Symmetries of the finish state: turns and reflections of the board which keep
+ * the empty piece on its finish place. A turned board with tiles renamed after
+ * the finish map is the same puzzle, its solution is the turned solution.
+ * Normal solution has the reflection by the main diagonal, snail solution has
+ * every turn for odd sizes and the reflection by the other diagonal for 4x4.
+ */
+class Symmetry
+{
+public:
+	struct Transform {
+		std::vector<int>	place;			// [place] -> place on the turned board
+		std::vector<int>	inversePlace;	// [place on the turned board] -> place
+		std::vector<int>	tile;			// [tile] -> its name on the turned board
+		int					move[LAST];		// [move] -> move on the turned board
+		int					inverseMove[LAST];
+	};
+
+private:
+	int						mapLength;
+	std::vector<Transform>	transforms;		// identity is the first one
+
+public:
+	Symmetry(int mapSize, int solutionType);
+
+	size_t				size() const { return (transforms.size()); }
+	const Transform		&operator[](size_t i) const { return (transforms[i]); }
+
+	// map has to be a permutation of [0, mapSize * mapSize)
+	void	apply(size_t transform, const int *map, int *turned) const;
+	// the least turned board by tiles order, returns its transform
+	size_t	canonical(const int *map, int *canonicalMap) const;
+
+	// moves of a path, ROOT stays in place
+	void	turnPath(size_t transform, std::list<int> &path) const;
+	void	restorePath(size_t transform, std::list<int> &path) const;
+};
+
+#endif // SYMMETRY_HPP
@@ -0,0 +1,467 @@
+#define BOOST_SPIRIT_THREADSAFE
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include "main.hpp"
+#include "CLI.hpp"
+#include "NPuzzleSolver.hpp"
+#include "PatternDatabase.hpp"
+
+/*
+ * Benchmark of the solver: fixed suites of puzzles are solved by every engine
+ * with every heuristic. A line of JSON per solve is printed to stdout (or --output),
+ * totals are printed to stderr. Results saved by an older build can be passed
+ * as --baseline, every solve which became slower, bigger or different is reported
+ * and the exit status is 1.
+ * $ ./npuzzle_bench -e 1,3 --output base.jsonl
+ * $ ./npuzzle_bench -e 1,3 --baseline base.jsonl
+ * Korf's 100 instances aren't in the repo, save them to map/korf100.txt and add the suite:
+ * $ ./npuzzle_bench -e 5 --suite korf
+ */
+
+std::string	fileName;
+int			verboseLevel = 0;
+
+struct Instance {
+	std::string			suite;
+	std::string			name;
+	int					mapSize;
+	int					solutionType;
+	std::vector<int>	map;
+};
+
+struct Engine {
+	const char	*name;
+	int			algorithm;
+	int			openList;
+	bool		deterministic;	// the same nodes are expanded by every run
+};
+
+static const Engine	engineTable[] = {
+	{"astar", A_STAR, BUCKET_QUEUE, true},
+	{"astar-heap", A_STAR, BINARY_HEAP, true},
+	{"idastar", IDA_STAR, BUCKET_QUEUE, true},
+	{"hdastar", HDA_STAR, BUCKET_QUEUE, false},
+	{"bastar", BA_STAR, BUCKET_QUEUE, true},
+};
+
+struct Run {
+	std::string	key;		// suite, instance, engine and heuristic
+	bool		deterministic;
+	std::string	status;
+	size_t		moves;
+	size_t		expanded;
+	size_t		generated;
+	size_t		memory;
+	double		time;
+};
+
+static std::vector<std::string>	splitList(const std::string &list) {
+	std::vector<std::string>	items;
+	std::stringstream			ss(list);
+	std::string					item;
+
+	while (std::getline(ss, item, ','))
+		if (!item.empty())
+			items.push_back(item);
+	return (items);
+}
+
+// maps of the directory, solution type is the one of the command line
+static void	mapsSuite(const std::string &directory, int solutionType, std::vector<Instance> &instances) {
+	namespace fs = boost::filesystem;
+	std::vector<std::string>	files;
+
+	if (!fs::is_directory(directory)) {
+		std::cerr << "Warning: no directory " << directory << ", suite 'maps' is skipped" << std::endl;
+		return ;
+	}
+	for (auto const &entry : fs::directory_iterator(directory))
+		if (fs::is_regular_file(entry.path()))
+			files.push_back(entry.path().string());
+	std::sort(files.begin(), files.end());
+
+	for (auto const &file : files) {
+		Instance	instance;
+
+		instance.suite = "maps";
+		instance.name = fs::path(file).filename().string();
+		instance.solutionType = solutionType;
+		CLI::readMap(file, instance.mapSize, instance.map);
+		instances.push_back(instance);
+	}
+}
+
+// random walks from the goal, so every puzzle is solvable and the same seed gives the same suite
+static void	randomSuite(int mapSize, int count, int walk, unsigned seed, int solutionType,
+						std::vector<Instance> &instances) {
+	std::mt19937	rng(seed);
+
+	for (int i = 0; i < count; i++) {
+		Instance	instance;
+		int			blank, previous = -1;
+
+		instance.suite = "random";
+		instance.name = std::to_string(mapSize) + "x" + std::to_string(mapSize) + "-" + std::to_string(i);
+		instance.mapSize = mapSize;
+		instance.solutionType = solutionType;
+		instance.map.resize(mapSize * mapSize);
+		State<NP_Board64>::makeFinishMap(solutionType, mapSize, instance.map.data());
+		blank = std::find(instance.map.begin(), instance.map.end(), 0) - instance.map.begin();
+
+		for (int step = 0; step < walk; step++) {
+			std::vector<int>	next;
+
+			if (blank % mapSize > 0)
+				next.push_back(blank - 1);
+			if (blank % mapSize < mapSize - 1)
+				next.push_back(blank + 1);
+			if (blank >= mapSize)
+				next.push_back(blank - mapSize);
+			if (blank < mapSize * (mapSize - 1))
+				next.push_back(blank + mapSize);
+			// don't undo the previous move
+			next.erase(std::remove(next.begin(), next.end(), previous), next.end());
+
+			int		place = next[rng() % next.size()];
+
+			std::swap(instance.map[blank], instance.map[place]);
+			previous = blank;
+			blank = place;
+		}
+		instances.push_back(instance);
+	}
+}
+
+/*
+ * Korf's 15-puzzle instances: a line per puzzle, 16 tiles, optionally
+ * preceded by number of the instance. Blank is the first place of Korf's goal,
+ * so the board is turned over and tiles are renumbered: t -> 16 - t.
+ * Lengths of paths stay the same, the goal becomes the linear one.
+ */
+static void	korfSuite(const std::string &file, std::vector<Instance> &instances) {
+	std::ifstream	input(file);
+	std::string		line;
+	int				number = 0;
+
+	// the suite is asked for by its name, so it isn't skipped quietly
+	if (!input.good())
+		throw std::invalid_argument("no file " + file + " of suite korf");
+	while (std::getline(input, line)) {
+		std::stringstream	ss(line.substr(0, line.find('#')));
+		std::vector<int>	values;
+		int					value;
+		Instance			instance;
+
+		while (ss >> value)
+			values.push_back(value);
+		if (values.empty())
+			continue ;
+		if (values.size() < 16)
+			throw CLI::CLI_InvalidMap();
+		number++;
+
+		const size_t	first = (values.size() > 16) ? 1 : 0;
+
+		instance.suite = "korf";
+		instance.name = std::to_string(first ? values[0] : number);
+		instance.mapSize = 4;
+		instance.solutionType = NORMAL_SOLUTION;
+		instance.map.resize(16);
+		for (size_t i = 0; i < 16; i++) {
+			const int	tile = values[first + i];
+
+			instance.map[15 - i] = (tile == 0) ? 0 : 16 - tile;
+		}
+		instances.push_back(instance);
+	}
+}
+
+static std::string	jsonString(const std::string &str) {
+	std::string	res = "\"";
+
+	for (auto c : str) {
+		if (c == '"' || c == '\\')
+			res += '\\';
+		res += c;
+	}
+	return (res + "\"");
+}
+
+static std::map<std::string, Run>	readBaseline(const std::string &file) {
+	namespace pt = boost::property_tree;
+	std::map<std::string, Run>	runs;
+	std::ifstream				input(file);
+	std::string					line;
+
+	if (!input.good())
+		throw CLI::CLI_InvalidFile();
+	while (std::getline(input, line)) {
+		std::stringstream	ss(line);
+		pt::ptree			json;
+		Run					run;
+
+		if (line.empty())
+			continue ;
+		pt::read_json(ss, json);
+		run.key = json.get<std::string>("suite") + "/" + json.get<std::string>("instance") + "/"
+					+ json.get<std::string>("engine") + "/h" + json.get<std::string>("heuristic");
+		run.status = json.get<std::string>("status");
+		run.moves = json.get<size_t>("moves");
+		run.expanded = json.get<size_t>("expanded");
+		run.generated = json.get<size_t>("generated");
+		run.memory = json.get<size_t>("memory");
+		run.time = json.get<double>("time");
+		runs[run.key] = run;
+	}
+	return (runs);
+}
+
+/*
+ * Solve is a regression if it isn't solved anymore, its amount of moves differs,
+ * or it became slower, bigger or expands more nodes than 'tolerance' allows.
+ * Times below 'minTime' are too noisy to be compared, so are nodes and memory
+ * of parallel search, they depend on the order of threads.
+ */
+static size_t	compare(const std::vector<Run> &runs, const std::map<std::string, Run> &baseline,
+						double tolerance, double minTime) {
+	size_t	regressions = 0, faster = 0, compared = 0;
+
+	auto	report = [&](const Run &run, const std::string &what) {
+		std::cerr << "Regression: " << run.key << ": " << what << std::endl;
+		regressions++;
+	};
+
+	for (auto const &run : runs) {
+		auto	it = baseline.find(run.key);
+
+		if (it == baseline.end())
+			continue ;
+		const Run	&base = it->second;
+
+		compared++;
+		if (base.status == "solved" && run.status != "solved") {
+			report(run, "status " + run.status);
+			continue ;
+		}
+		if (base.status != "solved" || run.status != "solved")
+			continue ;
+		if (run.moves != base.moves)
+			report(run, "moves " + std::to_string(base.moves) + " -> " + std::to_string(run.moves));
+		if (run.deterministic && run.expanded > base.expanded * (1 + tolerance))
+			report(run, "expanded " + std::to_string(base.expanded) + " -> " + std::to_string(run.expanded));
+		if (run.deterministic && run.memory > base.memory * (1 + tolerance))
+			report(run, "memory " + std::to_string(base.memory) + " -> " + std::to_string(run.memory));
+		if (std::max(run.time, base.time) >= minTime) {
+			if (run.time > base.time * (1 + tolerance))
+				report(run, "time " + std::to_string(base.time) + " -> " + std::to_string(run.time));
+			else if (run.time * (1 + tolerance) < base.time)
+				faster++;
+		}
+	}
+	std::cerr << "Compared with baseline: " << compared << " solves, " << regressions
+				<< " regressions, " << faster << " faster" << std::endl;
+	return (regressions);
+}
+
+int		main(int argc, char **argv) {
+	namespace po = boost::program_options;
+	po::options_description	desc("Options");
+	po::variables_map		vm;
+	std::vector<Instance>	instances;
+	std::vector<Run>		runs;
+	std::vector<int>		heuristics;
+	std::vector<Engine>		engines;
+	NP_budget				budget;
+	std::ofstream			outputFile;
+	int						solutionType, optimisation, threads, repeat;
+	int						size, count, walk;
+	unsigned				seed;
+	double					tolerance, minTime, weight;
+
+	desc.add_options()
+			("help,h", "Print help")
+			("suite", po::value<std::string>()->default_value("maps,random"),
+								"Suites of puzzles\n"
+								"\tmaps   -- maps of --maps directory\n"
+								"\trandom -- random walks from the goal\n"
+								"\tkorf   -- Korf's 15-puzzle instances\n"
+								"\t          of --korf file, the file\n"
+								"\t          isn't shipped, not run by\n"
+								"\t          default")
+			("maps", po::value<std::string>()->default_value("map/solvable"), "Directory with maps")
+			("korf", po::value<std::string>()->default_value("map/korf100.txt"),
+								"File with Korf's instances, 16 tiles per line,\n"
+								"\tblank is the first place of the goal")
+			("size,n", po::value<int>(&size)->default_value(4), "Side of random puzzles")
+			("count", po::value<int>(&count)->default_value(10), "Amount of random puzzles")
+			("walk", po::value<int>(&walk)->default_value(60), "Random moves from the goal")
+			("seed", po::value<unsigned>(&seed)->default_value(42), "Seed of random puzzles")
+			("heuristic,e", po::value<std::string>()->default_value("0,1,2,3,4,5"),
+								"Heuristics, numbers are the ones of npuzzle")
+			("engine", po::value<std::string>()->default_value("astar,astar-heap,idastar,hdastar"),
+								"Engines: astar, astar-heap, idastar, hdastar,\n"
+								"\tbastar (skips heuristic 5)")
+			("solution,s", po::value<int>(&solutionType)->default_value(SNAIL_SOLUTION),
+								"Solution type of maps and random puzzles")
+			("optimisation,o", po::value<int>(&optimisation)->default_value(BY_LENGTH),
+								"Optimisation, by paths' length by default")
+			("weight", po::value<double>(&weight)->default_value(NP_DEFAULT_WEIGHT, "2"),
+								"Weight of weighted and anytime optimisations")
+			("threads,t", po::value<int>(&threads)->default_value(0), "Threads of HDA*")
+			("repeat,r", po::value<int>(&repeat)->default_value(1), "Solves of every puzzle, the fastest counts")
+			("max-time", po::value<double>(&budget.maxTime)->default_value(10), "Time limit of a solve in seconds")
+			("max-memory", po::value<size_t>()->default_value(2048), "Memory limit of a solve in Mb")
+			("pdb,p", po::value<std::string>(&PatternDatabase::directory),
+								"Directory with pattern databases, 'pdb' by default")
+			("output", po::value<std::string>(), "File for results instead of stdout")
+			("baseline", po::value<std::string>(), "Results of an older run to compare with")
+			("tolerance", po::value<double>(&tolerance)->default_value(0.25, "0.25"),
+								"Allowed growth of time, memory and expanded nodes")
+			("min-time", po::value<double>(&minTime)->default_value(0.05, "0.05"),
+								"Faster solves aren't compared by time");
+
+	try {
+		po::store(po::parse_command_line(argc, argv, desc), vm);
+		if (vm.count("help")) {
+			std::cout << desc << std::endl;
+			return (0);
+		}
+		po::notify(vm);
+
+		budget.maxMemory = vm["max-memory"].as<size_t>() << 20;
+		for (auto const &heuristic : splitList(vm["heuristic"].as<std::string>()))
+			heuristics.push_back(std::stoi(heuristic));
+		for (auto const &name : splitList(vm["engine"].as<std::string>())) {
+			auto	it = std::find_if(std::begin(engineTable), std::end(engineTable),
+										[&](const Engine &engine) { return (name == engine.name); });
+
+			if (it == std::end(engineTable))
+				throw std::invalid_argument("unknown engine " + name);
+			engines.push_back(*it);
+		}
+		for (auto const &suite : splitList(vm["suite"].as<std::string>())) {
+			if (suite == "maps")
+				mapsSuite(vm["maps"].as<std::string>(), solutionType, instances);
+			else if (suite == "random")
+				randomSuite(size, count, walk, seed, solutionType, instances);
+			else if (suite == "korf")
+				korfSuite(vm["korf"].as<std::string>(), instances);
+			else
+				throw std::invalid_argument("unknown suite " + suite);
+		}
+		if (vm.count("output"))
+			outputFile.open(vm["output"].as<std::string>());
+	}
+	catch (po::error &e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		std::cerr << desc << std::endl;
+		return (1);
+	}
+	catch (std::exception &e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		return (1);
+	}
+
+	std::ostream	&output = outputFile.is_open() ? outputFile : std::cout;
+	NPuzzleSolver	solver;
+
+	solver.setWeight(weight);
+	PatternDatabase::preload();
+	std::cerr << "engine        h  solved  seconds  nodes per second  peak memory" << std::endl;
+	for (auto const &engine : engines) {
+		for (int heuristic : heuristics) {
+			// solver rejects pattern databases of bidirectional search for most of the maps
+			if (engine.algorithm == BA_STAR && heuristic == PATTERN_DATABASE)
+				continue ;
+
+			size_t	solved = 0, expanded = 0, peakMemory = 0;
+			double	seconds = 0;
+
+			for (auto const &instance : instances) {
+				Run		run;
+
+				run.key = instance.suite + "/" + instance.name + "/" + engine.name + "/h" + std::to_string(heuristic);
+				run.deterministic = engine.deterministic;
+				for (int i = 0; i < std::max(repeat, 1); i++) {
+					NP_retVal	result;
+					std::string	status = "solved";
+
+					try {
+						solver.solve(heuristic, instance.solutionType, instance.map.data(), instance.map.size(),
+										result, engine.openList, engine.algorithm, optimisation, threads, budget);
+					}
+					catch (std::exception &e) {
+						status = e.what();
+					}
+					if (i == 0 || result.elapsedTime < run.time) {
+						run.status = status;
+						// path starts with ROOT
+						run.moves = result.path.empty() ? 0 : result.path.size() - 1;
+						run.expanded = result.closedNodes;
+						run.generated = result.generatedNodes;
+						run.memory = result.usedMemory;
+						run.time = result.elapsedTime;
+					}
+					// there is no point to repeat a failed solve
+					if (status != "solved")
+						break ;
+				}
+
+				output << "{\"suite\":" << jsonString(instance.suite) << ",\"instance\":" << jsonString(instance.name)
+						<< ",\"engine\":" << jsonString(engine.name) << ",\"heuristic\":" << heuristic
+						<< ",\"status\":" << jsonString(run.status) << ",\"moves\":" << run.moves
+						<< ",\"expanded\":" << run.expanded << ",\"generated\":" << run.generated
+						<< ",\"memory\":" << run.memory << ",\"time\":" << run.time
+						<< ",\"nodesPerSecond\":" << (size_t)(run.time > 0 ? run.expanded / run.time : 0)
+						<< "}" << std::endl;
+				solved += (run.status == "solved");
+				expanded += run.expanded;
+				seconds += run.time;
+				peakMemory = std::max(peakMemory, run.memory);
+				runs.push_back(run);
+			}
+
+			std::stringstream	line;
+
+			line.setf(std::ios::fixed);
+			line.precision(2);
+			line.width(12);
+			line << std::left << engine.name << std::right;
+			line.width(3);
+			line << heuristic;
+			line.width(8);
+			line << solved;
+			line.width(9);
+			line << seconds;
+			line.width(18);
+			line << (size_t)(seconds > 0 ? expanded / seconds : 0);
+			line.width(13);
+			line << peakMemory;
+			std::cerr << line.str() << std::endl;
+		}
+	}
+
+	if (vm.count("baseline")) {
+		try {
+			if (compare(runs, readBaseline(vm["baseline"].as<std::string>()), tolerance, minTime) > 0)
+				return (1);
+		}
+		catch (std::exception &e) {
+			std::cerr << "Error: baseline: " << e.what() << std::endl;
+			return (1);
+		}
+	}
+	return (0);
+}
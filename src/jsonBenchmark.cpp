@@ -0,0 +1,237 @@
+#define BOOST_SPIRIT_THREADSAFE
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <list>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include "JsonCodec.hpp"
+
+/*
+ * Microbenchmark of the JSON of the server: a task of 5x5 puzzle is parsed and
+ * a solution of 300 moves, with improvements and a profile, is written by
+ * boost::property_tree (the former code of the server) and by JsonCodec / JsonWriter.
+ * Results of both must be the same, else the exit status is 1.
+ * $ ./npuzzle_json_bench [iterations]
+ */
+
+static const char	*taskMessage =
+	"{\"messageType\": 1, \"data\": {"
+	"\"map\": [1, 2, 3, 4, 5, 16, 17, 18, 19, 6, 15, 24, 0, 20, 7, 14, 23, 22, 21, 8, 13, 12, 11, 10, 9], "
+	"\"heuristicFunction\": 3, \"solutionType\": 1, \"algorithm\": 0, \"optimisation\": 3, "
+	"\"weight\": 2.5, \"threads\": 4, \"profile\": true, "
+	"\"maxTime\": 30, \"maxNodes\": 50000000, \"maxMemory\": 2147483648}}";
+
+static const char	*phaseNames[] = {"expand", "heuristic", "lookup", "insert"};
+
+// answer of a solve, the same fields as the answer of the server
+struct Answer {
+	std::list<int>		path;
+	size_t				openNodes;
+	size_t				closedNodes;
+	size_t				generatedNodes;
+	size_t				duplicates;
+	size_t				usedMemory;
+	double				elapsedTime;
+	size_t				nodesPerSecond;
+	std::vector<int>	improvementMoves;
+	std::vector<double>	improvementBounds;
+	std::vector<double>	improvementTimes;
+	double				phaseTime[4];
+	size_t				phaseCalls[4];
+};
+
+static void	parseTree(const std::string &json, NP_message &message) {
+	namespace pt = boost::property_tree;
+
+	std::stringstream	ss(json);
+	pt::ptree			root;
+
+	read_json(ss, root);
+
+	pt::ptree	&dataNode = root.get_child("data");
+
+	message.messageType = root.get<int>("messageType");
+	message.map.clear();
+	for (auto const &tile : dataNode.get_child("map"))
+		message.map.push_back(tile.second.get<int>(""));
+	message.heuristic = dataNode.get<int>("heuristicFunction");
+	message.solutionType = dataNode.get<int>("solutionType");
+	message.algorithm = dataNode.get<int>("algorithm", 0);
+	message.optimisation = dataNode.get<int>("optimisation");
+	message.weight = dataNode.get<double>("weight", 1);
+	message.threads = dataNode.get<int>("threads", 0);
+	message.profile = dataNode.get<bool>("profile", false);
+	message.maxTime = dataNode.get<double>("maxTime", 0);
+	message.maxNodes = dataNode.get<size_t>("maxNodes", 0);
+	message.maxMemory = dataNode.get<size_t>("maxMemory", 0);
+}
+
+static void	writeTree(const Answer &answer, std::string &out) {
+	namespace pt = boost::property_tree;
+
+	pt::ptree	root;
+	pt::ptree	dataNode;
+	pt::ptree	movesNode;
+	pt::ptree	improvementsNode;
+	pt::ptree	profileNode;
+
+	root.put("messageType", 2);
+	for (auto const &move : answer.path) {
+		pt::ptree	moveElem;
+
+		moveElem.put("", move);
+		movesNode.push_back(std::make_pair("", moveElem));
+	}
+	dataNode.add_child("movements", movesNode);
+	dataNode.put("openNodes", answer.openNodes);
+	dataNode.put("closedNodes", answer.closedNodes);
+	dataNode.put("generatedNodes", answer.generatedNodes);
+	dataNode.put("duplicates", answer.duplicates);
+	dataNode.put("usedMemory", answer.usedMemory);
+	dataNode.put("elapsedTime", answer.elapsedTime);
+	dataNode.put("nodesPerSecond", answer.nodesPerSecond);
+	dataNode.put("cached", false);
+	for (size_t i = 0; i < answer.improvementMoves.size(); i++) {
+		pt::ptree	improvementNode;
+
+		improvementNode.put("moves", answer.improvementMoves[i]);
+		improvementNode.put("bound", answer.improvementBounds[i]);
+		improvementNode.put("time", answer.improvementTimes[i]);
+		improvementsNode.push_back(std::make_pair("", improvementNode));
+	}
+	dataNode.add_child("improvements", improvementsNode);
+	for (int phase = 0; phase < 4; phase++) {
+		pt::ptree	phaseNode;
+
+		phaseNode.put("time", answer.phaseTime[phase]);
+		phaseNode.put("calls", answer.phaseCalls[phase]);
+		profileNode.add_child(phaseNames[phase], phaseNode);
+	}
+	dataNode.add_child("profile", profileNode);
+	root.add_child("data", dataNode);
+
+	std::stringstream	ss;
+
+	write_json(ss, root, false);
+	out = ss.str();
+}
+
+static void	writeDirect(const Answer &answer, std::string &out) {
+	JsonWriter	json(out);
+
+	out.clear();
+	out.reserve(512 + answer.path.size() * 4 + answer.improvementMoves.size() * 128);
+	json.beginObject();
+	json.put("messageType", 2);
+	json.beginObject("data");
+	json.beginArray("movements");
+	for (auto const &move : answer.path)
+		json.put(nullptr, move);
+	json.endArray();
+	json.put("openNodes", answer.openNodes);
+	json.put("closedNodes", answer.closedNodes);
+	json.put("generatedNodes", answer.generatedNodes);
+	json.put("duplicates", answer.duplicates);
+	json.put("usedMemory", answer.usedMemory);
+	json.put("elapsedTime", answer.elapsedTime);
+	json.put("nodesPerSecond", answer.nodesPerSecond);
+	json.put("cached", false);
+	json.beginArray("improvements");
+	for (size_t i = 0; i < answer.improvementMoves.size(); i++) {
+		json.beginObject();
+		json.put("moves", answer.improvementMoves[i]);
+		json.put("bound", answer.improvementBounds[i]);
+		json.put("time", answer.improvementTimes[i]);
+		json.endObject();
+	}
+	json.endArray();
+	json.beginObject("profile");
+	for (int phase = 0; phase < 4; phase++) {
+		json.beginObject(phaseNames[phase]);
+		json.put("time", answer.phaseTime[phase]);
+		json.put("calls", answer.phaseCalls[phase]);
+		json.endObject();
+	}
+	json.endObject();
+	json.endObject();
+	json.endObject();
+	json.finish();
+}
+
+static bool	sameMessage(const NP_message &lhs, const NP_message &rhs) {
+	return (lhs.messageType == rhs.messageType && lhs.map == rhs.map && lhs.heuristic == rhs.heuristic &&
+			lhs.solutionType == rhs.solutionType && lhs.algorithm == rhs.algorithm &&
+			lhs.optimisation == rhs.optimisation && lhs.weight == rhs.weight && lhs.threads == rhs.threads &&
+			lhs.profile == rhs.profile && lhs.maxTime == rhs.maxTime && lhs.maxNodes == rhs.maxNodes &&
+			lhs.maxMemory == rhs.maxMemory);
+}
+
+// nanoseconds per call of 'func'
+template <typename Func>
+static double	measure(size_t iterations, Func func) {
+	auto	start = std::chrono::steady_clock::now();
+
+	for (size_t i = 0; i < iterations; i++)
+		func();
+	return (std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations);
+}
+
+static void	report(const char *name, double tree, double direct) {
+	std::cout << name << ": property_tree " << (size_t)tree << " ns, direct " << (size_t)direct
+				<< " ns, x" << tree / direct << std::endl;
+}
+
+int		main(int argc, char **argv) {
+	const size_t	iterations = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 20000;
+	const std::string	task(taskMessage);
+	NP_message		treeMessage;
+	NP_message		directMessage;
+	Answer			answer;
+	std::string		treeAnswer;
+	std::string		directAnswer;
+
+	if (iterations == 0) {
+		std::cerr << "Usage: " << argv[0] << " [iterations]" << std::endl;
+		return (1);
+	}
+
+	for (int i = 0; i < 300; i++)
+		answer.path.push_back(i % 4);
+	answer.openNodes = 1843201;
+	answer.closedNodes = 2750113;
+	answer.generatedNodes = 7120558;
+	answer.duplicates = 401227;
+	answer.usedMemory = 412316860;
+	answer.elapsedTime = 3.0712345;
+	answer.nodesPerSecond = 895443;
+	for (int i = 0; i < 5; i++) {
+		answer.improvementMoves.push_back(380 - i * 16);
+		answer.improvementBounds.push_back(2.5 - i * 0.3);
+		answer.improvementTimes.push_back(0.1 * (i + 1) * (i + 1));
+	}
+	for (int phase = 0; phase < 4; phase++) {
+		answer.phaseTime[phase] = 0.25 * (phase + 1) / 3;
+		answer.phaseCalls[phase] = 2750113 * (phase + 1);
+	}
+
+	parseTree(task, treeMessage);
+	JsonCodec::parse(task, directMessage);
+	writeTree(answer, treeAnswer);
+	writeDirect(answer, directAnswer);
+	if (!sameMessage(treeMessage, directMessage) || treeAnswer != directAnswer) {
+		std::cerr << "Results differ:" << std::endl << treeAnswer << directAnswer;
+		return (1);
+	}
+
+	report("parse task", measure(iterations, [&]() { parseTree(task, treeMessage); }),
+			measure(iterations, [&]() { directMessage = NP_message(); JsonCodec::parse(task, directMessage); }));
+	report("write solution", measure(iterations, [&]() { writeTree(answer, treeAnswer); }),
+			measure(iterations, [&]() { writeDirect(answer, directAnswer); }));
+	return (0);
+}
@@ -2,6 +2,7 @@
 #include <client_http.hpp>
 #include <server_http.hpp>
 #include "NPuzzleSolver.hpp"
+#include <algorithm>
 #include <array>
 #include <boost/program_options.hpp>
 
@@ -15,14 +16,12 @@
 
 #include "CSCP.hpp"
 #include "CLI.hpp"
+#include "PatternDatabase.hpp"
 
 std::string	fileName;
 int	verboseLevel = 0;
-int	optimisationByTime = 1;
 
 using namespace std;
-// Added for the json-example:
-using namespace boost::property_tree;
 
 using HttpServer = SimpleWeb::Server<SimpleWeb::HTTP>;
 using HttpClient = SimpleWeb::Client<SimpleWeb::HTTP>;
@@ -43,18 +42,31 @@ void sigFaultHandler(int sig) {
 int		main(int argc, char **argv) {
 	try {
 		boost::thread	*server_thread;
+		size_t			pdbCount;
 		CLI				cli(argc, argv);
-		CSCP			mp;
+		int				workers = boost::thread::hardware_concurrency();
+		int				cacheSize = 0;
+		std::string		cacheFile;
 
 		signal(SIGSEGV, sigFaultHandler);
 
 		if (cli.isFlagSet("help"))
 			return (0);
-		if (cli.isFlagSet("file")) {
+		if (cli.isFlagSet("file") || cli.isFlagSet("batch")) {
 			cli.startLogic();
 			return (0);
 		}
 
+		// map pattern databases once, every task of the server shares them
+		pdbCount = PatternDatabase::preload();
+		if (verboseLevel & NP_VBL_SERVER)
+			std::cout << "Pattern databases mapped: " << pdbCount << std::endl;
+
+		cli.getFlag("workers", workers);
+		cli.getFlag("cache", cacheSize);
+		cli.getFlag("cache-file", cacheFile);
+		CSCP	mp(workers > 0 ? workers : 1, cli.getBudget(), (size_t)std::max(cacheSize, 0) << 20, cacheFile);
+
 		server_thread = mp.serverStart();
 		std::cout << "Open browser page at address http://localhost:8080" << std::endl;
 
@@ -13,7 +13,6 @@ enum verboseLevel_e { NONE, SERVER, ALGO };
 
 extern std::string	fileName;
 extern int	verboseLevel;
-extern int	optimisationByTime;
 
 #endif // MAIN_HPP
 
@@ -28,8 +27,8 @@ extern int	optimisationByTime;
 	TODO:
 		+1. Makefile for macos
 		+2. -std=c++11 in Makefile ?
-		-3. Start new thread to solve puzzle, and send signal if client
-			was send a stop message : server is not asynchronus
+		+3. Start new thread to solve puzzle, and send signal if client
+			was send a stop message / task is cancelled when client is gone
 		-4. Use unsigned int in everywhere in NPuzzleSolver / doesn't needed
 		+5. Make an API of NPuzzleSolver, means in header files must be
 			everything what needs for NPuzzleSolver
@@ -41,7 +40,7 @@ extern int	optimisationByTime;
 		*-11. Use multithreads to find solution in NPuzzleSolver.cpp / this doesn't increase speed
 		+12. Put to NPuzzleSolver opennodes, closednodes, momory used
 		-13. rvalue reference, use it to return value from function
-		-14. Add mutex to NPuzzleSolver: stop task only when task is running
+		+14. Add mutex to NPuzzleSolver: stop task only when task is running / NP_budget.cancel
 		+15. Snail solution, discovery
 		-16. Asynchronus response from server
 		+17. Figure out how to build finishState
@@ -76,3 +75,16 @@ This automatically closes "issue #23"
  * $ gprof a.out > prof.txt
  * g++ -std=c++11 -I $HOME/.brew/Cellar/boost/1.67.0_1/include -L $HOME/.brew/Cellar/boost/1.67.0_1/lib  -lboost_system  -lboost_thread-mt
  */
+
+/*
+ * How to cross-check incremental heuristics with the full-board ones
+ * add -DNP_CHECK_HEURISTIC to FLAGS in Makefile and rebuild with $ make re
+ */
+
+/*
+ * How to catch performance regressions
+ * $ make bench && ./npuzzle_bench -e 3,5 -r 3 --output base.jsonl
+ * change the solver, then
+ * $ make bench && ./npuzzle_bench -e 3,5 -r 3 --baseline base.jsonl
+ * Korf's 100 instances are read from map/korf100.txt (--korf)
+ */
@@ -0,0 +1,99 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <ctime>
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include "PatternDatabase.hpp"
+#include "State.hpp"
+
+/*
+ * Builds pattern databases for the PATTERN_DATABASE heuristic.
+ * Tables are written once into PatternDatabase::directory and are mapped
+ * by npuzzle at start, so restarts of the server don't rebuild them.
+ * 7-8 layout for 4x4 needs about 3.5Gb of memory while it's generated.
+ * Patterns which are mirrors of other ones by a symmetry of the finish state
+ * share their tables, so they aren't generated.
+ */
+
+static void	generateLayout(int mapSize, int solutionType, const std::string &layout) {
+	int		finishMap[mapSize * mapSize];
+
+	State<NP_Board64>::makeFinishMap(solutionType, mapSize, finishMap);
+	const std::vector<std::vector<int>>	groups = PatternDatabase::partition(finishMap, mapSize, layout);
+	const Symmetry						symmetry(mapSize, solutionType);
+
+	for (size_t i = 0; i < groups.size(); i++) {
+		const std::string	path = PatternDatabase::fileName(mapSize, solutionType, layout, i);
+		PatternDatabase		pdb(mapSize, groups[i]);
+		clock_t				start = clock();
+		size_t				transform;
+		const int			mirror = PatternDatabase::mirrorOf(symmetry, groups, i, transform);
+
+		if (mirror >= 0) {
+			std::cout << path << ": mirror of " << PatternDatabase::fileName(mapSize, solutionType, layout, mirror)
+						<< ", not needed" << std::endl;
+			continue;
+		}
+		std::cout << path << ": " << groups[i].size() << " tiles, "
+					<< pdb.getEntries() << " entries" << std::flush;
+		pdb.generate(finishMap);
+		pdb.save(path, solutionType);
+		std::cout << ", " << (float)(clock() - start) / CLOCKS_PER_SEC << " sec." << std::endl;
+	}
+}
+
+int		main(int argc, char **argv) {
+	namespace po = boost::program_options;
+	po::options_description	desc("Options");
+	po::variables_map		vm;
+	std::vector<int>		solutionTypes;
+	std::string				layout;
+	int						mapSize;
+
+	desc.add_options()
+			("help,h", "Print help")
+			("size,n", po::value<int>(&mapSize)->required(), "Size of map, 3 to 5")
+			("solution,s", po::value<int>(), "Solution type\n"
+								"\t0 -- snail solution\n"
+								"\t1 -- linear solution\n"
+								"\tboth of them if not set")
+			("layout,l", po::value<std::string>(&layout), "Partition of tiles\n"
+								"\t3x3 -- 44\n"
+								"\t4x4 -- 78, 663 (default)\n"
+								"\t5x5 -- 6666, 6666p (default)")
+			("dir,d", po::value<std::string>(&PatternDatabase::directory), "Output directory, 'pdb' by default");
+
+	try {
+		po::store(po::parse_command_line(argc, argv, desc), vm);
+		if (vm.count("help")) {
+			std::cout << desc << std::endl;
+			return (0);
+		}
+		po::notify(vm);
+
+		if (vm.count("solution"))
+			solutionTypes.push_back(vm["solution"].as<int>());
+		else
+			solutionTypes = {SNAIL_SOLUTION, NORMAL_SOLUTION};
+
+		// the cheapest layout by default
+		if (layout.empty() && !PatternDatabase::layouts(mapSize).empty())
+			layout = PatternDatabase::layouts(mapSize).back();
+
+		boost::filesystem::create_directories(PatternDatabase::directory);
+		for (int solutionType : solutionTypes)
+			generateLayout(mapSize, solutionType, layout);
+	}
+	catch (po::error &e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		std::cerr << desc << std::endl;
+		return (1);
+	}
+	catch (std::exception &e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		return (1);
+	}
+	return (0);
+}
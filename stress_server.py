@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+
+# Stress test of the solving server: the same set of random puzzles is sent
+# by 1, 2, 4 ... N concurrent clients, throughput should grow with amount of cores.
+# Start the server first, e.g.  $ ./npuzzle -w 8
+
+import argparse
+import json
+import os
+import random
+import time
+import urllib.request
+from concurrent.futures import ThreadPoolExecutor
+
+def make_goal(s):
+	puzzle = [i + 1 for i in range(s * s)]
+	puzzle[-1] = 0
+	return puzzle
+
+def make_puzzle(s, iterations):
+	p = make_goal(s)
+	prev = -1
+	for i in range(iterations):
+		idx = p.index(0)
+		poss = []
+		if idx % s > 0:
+			poss.append(idx - 1)
+		if idx % s < s - 1:
+			poss.append(idx + 1)
+		if idx // s > 0:
+			poss.append(idx - s)
+		if idx // s < s - 1:
+			poss.append(idx + s)
+		poss = [i for i in poss if i != prev] or poss
+		swi = random.choice(poss)
+		p[idx] = p[swi]
+		p[swi] = 0
+		prev = idx
+	return p
+
+def send_task(url, puzzle, heuristic):
+	body = json.dumps({
+		"messageType": 0,
+		"data": {
+			"map": puzzle,
+			"heuristicFunction": heuristic,
+			"solutionType": 1,
+			"optimisation": 0,
+			"algorithm": 0
+		}
+	}).encode()
+	request = urllib.request.Request(url, data=body, headers={"Content-Type": "application/json"})
+	with urllib.request.urlopen(request) as response:
+		answer = json.loads(response.read().decode())
+	if answer["messageType"] != 1:
+		raise RuntimeError(answer["data"]["message"])
+
+def run(url, puzzles, heuristic, clients):
+	start = time.time()
+	with ThreadPoolExecutor(max_workers=clients) as pool:
+		for future in [pool.submit(send_task, url, p, heuristic) for p in puzzles]:
+			future.result()
+	return time.time() - start
+
+if __name__ == "__main__":
+	parser = argparse.ArgumentParser()
+
+	parser.add_argument("-u", "--url", default="http://localhost:8080/message", help="Address of the server")
+	parser.add_argument("-s", "--size", type=int, default=4, help="Size of the puzzle's side")
+	parser.add_argument("-t", "--tasks", type=int, default=64, help="Amount of puzzles in one run")
+	parser.add_argument("-c", "--clients", type=int, default=os.cpu_count(), help="Max amount of concurrent clients")
+	parser.add_argument("-e", "--heuristic", type=int, default=3, help="Heuristic of every task")
+	parser.add_argument("-i", "--iterations", type=int, default=60, help="Random moves from the goal")
+	parser.add_argument("--seed", type=int, default=42)
+
+	args = parser.parse_args()
+
+	random.seed(args.seed)
+	puzzles = [make_puzzle(args.size, args.iterations) for i in range(args.tasks)]
+
+	clients = 1
+	base = None
+	print("clients  seconds  tasks/sec  speedup")
+	while True:
+		elapsed = run(args.url, puzzles, args.heuristic, clients)
+		base = base or elapsed
+		print("%7d  %7.2f  %9.2f  %7.2f" % (clients, elapsed, args.tasks / elapsed, base / elapsed))
+		if clients >= args.clients:
+			break
+		clients = min(clients * 2, args.clients)
@@ -213,10 +213,15 @@ function hellSecret(num) {
 function handleMetainfo(msg) {
   var openNodes = document.getElementById('oN');
   var closedNodes = document.getElementById('cN');
+  var generatedNodes = document.getElementById('gN');
+  var nodesPerSecond = document.getElementById('nps');
   var elapsedTime = document.getElementById('eTime');
   var usedMemory = document.getElementById('usedMemory');
   openNodes.innerHTML = '<b>Open nodes:</b> ' + msg.data.openNodes;
   closedNodes.innerHTML = '<b>Closed nodes:</b> ' + msg.data.closedNodes;
+  generatedNodes.innerHTML = '<b>Generated nodes:</b> ' + msg.data.generatedNodes +
+    ' (' + msg.data.duplicates + ' duplicates)';
+  nodesPerSecond.innerHTML = '<b>Nodes per second:</b> ' + msg.data.nodesPerSecond;
   elapsedTime.innerHTML = '<b>Elapsed time:</b> ' + msg.data.elapsedTime + ' seconds';
   usedMemory.innerHTML = '<b>Used memory:</b> ' + msg.data.usedMemory + ' bytes';
 }
@@ -256,8 +261,16 @@ function takeForm(form, puzzle) {
       recive.data.solutionType = i;
     }
   });
+
+  elements.group4.forEach((item, i) => {
+    if (item.checked === true) {
+      recive.data.algorithm = i;
+    }
+  });
   if (isNaN(elements.side.value) || isNaN(elements.iterations.value)) {
     $('#cN').empty();
+    $('#gN').empty();
+    $('#nps').empty();
     $('#eTime').empty();
     $('#usedMemory').empty();
     var openNodes = document.getElementById('oN');
@@ -268,17 +281,49 @@ function takeForm(form, puzzle) {
   JSON.stringify(recive);
   puzzle = new Puzzle(document.getElementById('puzzle'), elements, recive);
 
-  $.ajax({
-    type: 'POST',
-    url: '/message',
-    data: JSON.stringify(recive),
-    success(msg) {
-      msg = JSON.parse(msg);
-      const moves = msg.data.movements;
-      console.log(moves);
-      console.log(msg);
+  streamTask(recive, (msg) => {
+    const moves = msg.data.movements;
+    console.log(moves);
+    console.log(msg);
 	  handleMetainfo(msg);
-      if (moves !== undefined) { handleResponse(msg.data.movements, puzzle); }
-    },
+    if (moves !== undefined) { handleResponse(msg.data.movements, puzzle); }
+  });
+}
+
+function handleProgress(msg) {
+  document.getElementById('oN').innerHTML = '<b>Open nodes:</b> ' + msg.data.openNodes;
+  document.getElementById('cN').innerHTML = '<b>Closed nodes:</b> ' + msg.data.closedNodes;
+  document.getElementById('gN').innerHTML = '<b>Bound:</b> ' + msg.data.bound;
+  document.getElementById('nps').innerHTML = '<b>Nodes per second:</b> ' + msg.data.nodesPerSecond;
+  document.getElementById('eTime').innerHTML = '<b>Elapsed time:</b> ' + msg.data.elapsedTime + ' seconds';
+  document.getElementById('usedMemory').innerHTML = '<b>Used memory:</b> ' + msg.data.usedMemory + ' bytes';
+}
+
+// /stream answers with server-sent events: 'progress' while the task is solved, then 'result'
+function streamTask(task, onResult) {
+  fetch('/stream', { method: 'POST', body: JSON.stringify(task) }).then((response) => {
+    const reader = response.body.getReader();
+    const decoder = new TextDecoder();
+    let buffer = '';
+
+    function read() {
+      return reader.read().then(({ done, value }) => {
+        let end;
+
+        if (done) { return; }
+        buffer += decoder.decode(value, { stream: true });
+        while ((end = buffer.indexOf('\n\n')) >= 0) {
+          const lines = buffer.slice(0, end).split('\n');
+          const name = lines.filter(line => line.startsWith('event: ')).map(line => line.slice(7))[0];
+          const data = lines.filter(line => line.startsWith('data: ')).map(line => line.slice(6)).join('\n');
+
+          buffer = buffer.slice(end + 2);
+          if (name === 'progress') { handleProgress(JSON.parse(data)); }
+          if (name === 'result') { onResult(JSON.parse(data)); }
+        }
+        return read();
+      });
+    }
+    return read();
   });
 }